@@ -0,0 +1,190 @@
+#include "decoder.h"
+
+#include <string.h>
+#include "deinterleave.h"
+#include "find_timestamp.h"
+#include "number.h"
+
+/* Control frames have the lowest bit of their first word set. */
+#define IS_CONTROL(p) ((p)[3] & 1)
+
+static size_t frame_length(const kum_6d6_decoder *d, const uint8_t *p)
+{
+  return IS_CONTROL(p) ? 16 : 4 * d->channel_count;
+}
+
+static void decode_event(kum_6d6_decoder *d, const uint8_t *p, int64_t offset)
+{
+  kum_6d6_event *e = &d->event;
+  int k;
+
+  for (k = 0; k < 4; ++k) {
+    e->frame[k] = ld_i32_be(p + 4 * k);
+  }
+  e->type = e->frame[0];
+  e->offset = offset;
+  e->sample_number = d->sample_number;
+  switch (e->type) {
+  case KUM_6D6_TIME:
+    e->time = e->frame[1] * (int64_t) 1000000 + e->frame[2];
+    break;
+  case KUM_6D6_VBAT:
+    e->vbat = e->frame[1] >> 16;
+    e->humidity = e->frame[1] & 0xffff;
+    break;
+  case KUM_6D6_TEMPERATURE:
+    e->temperature = e->frame[1] >> 16;
+    break;
+  default: break;
+  }
+}
+
+static void decode_samples(kum_6d6_decoder *d, const uint8_t *p)
+{
+  int c;
+
+  for (c = 0; c < d->channel_count; ++c) {
+    d->samples[c][d->count] = ld_i32_be(p + 4 * c);
+  }
+  d->count += 1;
+  d->sample_number += 1;
+}
+
+static void advance(kum_6d6_decoder *d, size_t n)
+{
+  d->data += n;
+  d->length -= n;
+  d->offset += n;
+}
+
+extern int kum_6d6_decoder_init(kum_6d6_decoder *d, int channel_count)
+{
+  if (!d || channel_count < 1 || channel_count > KUM_6D6_MAX_CHANNEL_COUNT) return -1;
+  memset(d, 0, sizeof(*d));
+  d->channel_count = channel_count;
+  d->deinterleave = kum_6d6_deinterleave_select(channel_count);
+  return 0;
+}
+
+extern void kum_6d6_decoder_feed(kum_6d6_decoder *d, const void *data, size_t length)
+{
+  d->data = data;
+  d->length = length;
+}
+
+extern int kum_6d6_decoder_next(kum_6d6_decoder *d)
+{
+  int32_t *out[KUM_6D6_MAX_CHANNEL_COUNT];
+  size_t need, n;
+  int c, frames;
+
+  d->count = 0;
+
+  /* Complete the frame which crossed the end of the last buffer. */
+  while (d->partial_length) {
+    need = d->partial_length < 4 ? 4 : frame_length(d, d->partial);
+    if (d->partial_length == need) {
+      d->partial_length = 0;
+      if (IS_CONTROL(d->partial)) {
+        decode_event(d, d->partial, d->offset - need);
+        return KUM_6D6_DECODER_EVENT;
+      }
+      decode_samples(d, d->partial);
+      break;
+    }
+    if (!d->length) return KUM_6D6_DECODER_NEED_DATA;
+    n = need - d->partial_length < d->length ? need - d->partial_length : d->length;
+    memcpy(d->partial + d->partial_length, d->data, n);
+    d->partial_length += n;
+    advance(d, n);
+  }
+
+  while (d->count < KUM_6D6_DECODER_BATCH && d->length >= 4) {
+    /* Runs of sample frames go through the fast kernels. */
+    frames = d->length / (4 * d->channel_count);
+    if (frames > KUM_6D6_DECODER_BATCH - d->count) frames = KUM_6D6_DECODER_BATCH - d->count;
+    for (c = 0; c < d->channel_count; ++c) {
+      out[c] = d->samples[c] + d->count;
+    }
+    if ((frames = d->deinterleave(d->data, frames, out))) {
+      d->count += frames;
+      d->sample_number += frames;
+      advance(d, frames * 4 * d->channel_count);
+      continue;
+    }
+
+    need = frame_length(d, d->data);
+    if (d->length < need) break;
+    if (IS_CONTROL(d->data)) {
+      /* The samples before the control frame come first. */
+      if (d->count) break;
+      decode_event(d, d->data, d->offset);
+      advance(d, need);
+      return KUM_6D6_DECODER_EVENT;
+    }
+    decode_samples(d, d->data);
+    advance(d, need);
+  }
+  if (d->count) return KUM_6D6_DECODER_SAMPLES;
+
+  /* Keep the start of an incomplete frame for the next buffer. */
+  memcpy(d->partial, d->data, d->length);
+  d->partial_length = d->length;
+  advance(d, d->length);
+  return KUM_6D6_DECODER_NEED_DATA;
+}
+
+extern int kum_6d6_decoder_next_event(kum_6d6_decoder *d)
+{
+  size_t need, n, frame = 4 * d->channel_count;
+
+  d->count = 0;
+
+  /* Complete the frame which crossed the end of the last buffer. */
+  while (d->partial_length) {
+    need = d->partial_length < 4 ? 4 : frame_length(d, d->partial);
+    if (d->partial_length == need) {
+      d->partial_length = 0;
+      if (IS_CONTROL(d->partial)) {
+        decode_event(d, d->partial, d->offset - need);
+        return KUM_6D6_DECODER_EVENT;
+      }
+      d->sample_number += 1;
+      break;
+    }
+    if (!d->length) return KUM_6D6_DECODER_NEED_DATA;
+    n = need - d->partial_length < d->length ? need - d->partial_length : d->length;
+    memcpy(d->partial + d->partial_length, d->data, n);
+    d->partial_length += n;
+    advance(d, n);
+  }
+
+  while (d->length >= 4) {
+    if (IS_CONTROL(d->data)) {
+      if (d->length < 16) break;
+      decode_event(d, d->data, d->offset);
+      advance(d, 16);
+      return KUM_6D6_DECODER_EVENT;
+    }
+    /* Every frame which starts before the next odd word is a sample frame.
+     * On broken data the odd word may be inside of a frame, then that frame
+     * is a sample frame, too. */
+    n = kum_6d6_next_control(d->data, d->length) / frame;
+    if (!n && d->length >= frame) n = 1;
+    if (!n) break;
+    d->sample_number += n;
+    advance(d, n * frame);
+  }
+
+  /* Keep the start of an incomplete frame for the next buffer. */
+  memcpy(d->partial, d->data, d->length);
+  d->partial_length = d->length;
+  advance(d, d->length);
+  return KUM_6D6_DECODER_NEED_DATA;
+}
+
+extern int64_t kum_6d6_resync(const void *data, size_t length)
+{
+  kum_6d6_timestamp t;
+  return kum_6d6_find_timestamps(data, length, 0, &t, 1) ? t.offset : -1;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "6d6.h"
+#include "deinterleave.h"
+
+/* Types of control frames. The type is the first word of the frame. */
+#define KUM_6D6_TIME 1
+#define KUM_6D6_VBAT 3
+#define KUM_6D6_TEMPERATURE 5
+#define KUM_6D6_LOST 7
+#define KUM_6D6_CHECK 9
+#define KUM_6D6_REBOOT 11
+#define KUM_6D6_END 13
+#define KUM_6D6_FRAME_NUMBER 15
+
+/* Results of kum_6d6_decoder_next. */
+#define KUM_6D6_DECODER_NEED_DATA 0
+#define KUM_6D6_DECODER_SAMPLES 1
+#define KUM_6D6_DECODER_EVENT 2
+
+/* Maximum number of sample frames returned at once. */
+#define KUM_6D6_DECODER_BATCH 1024
+
+/* A control frame. */
+typedef struct {
+  int32_t type;
+  /* The raw words of the frame, including the type. */
+  int32_t frame[4];
+  /* Offset of the frame from the start of the data. */
+  int64_t offset;
+  /* Number of sample frames before this one. */
+  int64_t sample_number;
+  /* KUM_6D6_TIME: Microseconds since the start time. */
+  int64_t time;
+  /* KUM_6D6_VBAT: Battery voltage in 10 mV and humidity in percent. */
+  int vbat, humidity;
+  /* KUM_6D6_TEMPERATURE: Temperature in 0.01 °C. */
+  int temperature;
+} kum_6d6_event;
+
+/* Decodes the data blocks of a 6D6 recording.
+ * The data may be fed in buffers of any size, frames may cross them. */
+typedef struct {
+  int channel_count;
+  /* The sample frames of the last KUM_6D6_DECODER_SAMPLES, one array for
+   * every channel. */
+  int32_t samples[KUM_6D6_MAX_CHANNEL_COUNT][KUM_6D6_DECODER_BATCH];
+  int count;
+  /* The control frame of the last KUM_6D6_DECODER_EVENT. */
+  kum_6d6_event event;
+  /* Number of sample frames decoded so far. */
+  int64_t sample_number;
+
+  /* Private. */
+  kum_6d6_deinterleave_kernel deinterleave;
+  const uint8_t *data;
+  size_t length;
+  int64_t offset;
+  uint8_t partial[4 * KUM_6D6_MAX_CHANNEL_COUNT];
+  int partial_length;
+} kum_6d6_decoder;
+
+/* Prepare a decoder for the given number of channels.
+ * Returns 0 on success and -1 if the channel count is invalid. */
+extern int kum_6d6_decoder_init(kum_6d6_decoder *decoder, int channel_count);
+
+/* Pass the next buffer of data to the decoder.
+ * The buffer must stay valid until kum_6d6_decoder_next returns
+ * KUM_6D6_DECODER_NEED_DATA. */
+extern void kum_6d6_decoder_feed(kum_6d6_decoder *decoder, const void *data, size_t length);
+
+/* Decode the next part of the buffer.
+ * Returns KUM_6D6_DECODER_SAMPLES if `count` sample frames are in `samples`,
+ * KUM_6D6_DECODER_EVENT if a control frame is in `event`, and
+ * KUM_6D6_DECODER_NEED_DATA once the buffer is used up. */
+extern int kum_6d6_decoder_next(kum_6d6_decoder *decoder);
+
+/* Like kum_6d6_decoder_next, but only returns the control frames. Sample
+ * frames are counted in `sample_number` and skipped without decoding them,
+ * which runs at about the speed of memory.
+ * Returns KUM_6D6_DECODER_EVENT or KUM_6D6_DECODER_NEED_DATA. */
+extern int kum_6d6_decoder_next_event(kum_6d6_decoder *decoder);
+
+/* Find the first time frame in `data` without knowing where the frames
+ * start. Sample words are even and control frames have four words, so after
+ * four even words the next odd word starts a control frame. `data` must be
+ * aligned to words.
+ * Returns the offset of the time frame or -1 if there is none. */
+extern int64_t kum_6d6_resync(const void *data, size_t length);
@@ -0,0 +1,195 @@
+#include "deinterleave.h"
+
+#include <string.h>
+
+/* Control frames have the lowest bit of their first word set. */
+#define IS_CONTROL(p) ((p)[3] & 1)
+
+/* One kernel for every channel count, so that the channel count is a
+ * constant and the loop over the channels is unrolled. Groups of four frames
+ * are checked for control frames at once, which leaves fewer branches for
+ * recordings with few channels. */
+#define DEINTERLEAVE_FIXED(n) \
+static int deinterleave##n(const uint8_t *p, int count, int32_t *const *out) \
+{ \
+  int32_t *o[n]; \
+  uint32_t x; \
+  int k = 0, c, j; \
+ \
+  for (c = 0; c < n; ++c) { \
+    o[c] = out[c]; \
+  } \
+  for (; k + 4 <= count; k += 4) { \
+    if ((p[3] | p[4 * n + 3] | p[8 * n + 3] | p[12 * n + 3]) & 1) break; \
+    for (j = 0; j < 4; ++j) { \
+      _Pragma("GCC unroll 8") \
+      for (c = 0; c < n; ++c) { \
+        memcpy(&x, p + 4 * (n * j + c), 4); \
+        o[c][k + j] = __builtin_bswap32(x); \
+      } \
+    } \
+    p += 16 * n; \
+  } \
+  for (; k < count; ++k) { \
+    if (IS_CONTROL(p)) break; \
+    _Pragma("GCC unroll 8") \
+    for (c = 0; c < n; ++c) { \
+      memcpy(&x, p + 4 * c, 4); \
+      o[c][k] = __builtin_bswap32(x); \
+    } \
+    p += 4 * n; \
+  } \
+  return k; \
+}
+
+DEINTERLEAVE_FIXED(1)
+DEINTERLEAVE_FIXED(2)
+DEINTERLEAVE_FIXED(3)
+DEINTERLEAVE_FIXED(5)
+DEINTERLEAVE_FIXED(6)
+DEINTERLEAVE_FIXED(7)
+DEINTERLEAVE_FIXED(8)
+
+/* Four channels fill exactly 16 bytes per frame. The loop is simple enough
+ * for compilers to vectorize it on targets without a special kernel. */
+static int deinterleave4_generic(const uint8_t *p, int count, int32_t *const *out)
+{
+  int32_t *a = out[0], *b = out[1], *c = out[2], *d = out[3];
+  uint32_t x[4];
+  int k;
+
+  for (k = 0; k < count; ++k) {
+    if (IS_CONTROL(p)) break;
+    memcpy(x, p, 16);
+    a[k] = __builtin_bswap32(x[0]);
+    b[k] = __builtin_bswap32(x[1]);
+    c[k] = __builtin_bswap32(x[2]);
+    d[k] = __builtin_bswap32(x[3]);
+    p += 16;
+  }
+  return k;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DEINTERLEAVE_HARDWARE
+
+/* Four frames per step: swap the bytes of every word, then transpose the
+ * 4x4 block of words. The first row holds the first word of each frame, so
+ * its lowest bits tell whether there is a control frame among them. */
+__attribute__((target("ssse3")))
+static int deinterleave4_ssse3(const uint8_t *p, int count, int32_t *const *out)
+{
+  const __m128i swap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  __m128i a, b, c, d, t0, t1, t2, t3, r0;
+  int k;
+
+  for (k = 0; k + 4 <= count; k += 4) {
+    a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) p), swap);
+    b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (p + 16)), swap);
+    c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (p + 32)), swap);
+    d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (p + 48)), swap);
+    t0 = _mm_unpacklo_epi32(a, b);
+    t1 = _mm_unpacklo_epi32(c, d);
+    r0 = _mm_unpacklo_epi64(t0, t1);
+    if (_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(r0, 31)))) break;
+    t2 = _mm_unpackhi_epi32(a, b);
+    t3 = _mm_unpackhi_epi32(c, d);
+    _mm_storeu_si128((__m128i *) (out[0] + k), r0);
+    _mm_storeu_si128((__m128i *) (out[1] + k), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i *) (out[2] + k), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i *) (out[3] + k), _mm_unpackhi_epi64(t2, t3));
+    p += 64;
+  }
+  return k;
+}
+
+/* Like the SSSE3 kernel with eight frames per step. Every 128 bit lane is
+ * transposed on its own, so the words have to be put in order afterwards. */
+__attribute__((target("avx2")))
+static int deinterleave4_avx2(const uint8_t *p, int count, int32_t *const *out)
+{
+  const __m256i swap = _mm256_set_epi8(
+    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  const __m256i order = _mm256_set_epi32(7, 3, 6, 2, 5, 1, 4, 0);
+  __m256i a, b, c, d, t0, t1, t2, t3, r0;
+  int k;
+
+  for (k = 0; k + 8 <= count; k += 8) {
+    a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) p), swap);
+    b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) (p + 32)), swap);
+    c = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) (p + 64)), swap);
+    d = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) (p + 96)), swap);
+    t0 = _mm256_unpacklo_epi32(a, b);
+    t1 = _mm256_unpacklo_epi32(c, d);
+    r0 = _mm256_unpacklo_epi64(t0, t1);
+    if (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(r0, 31)))) break;
+    t2 = _mm256_unpackhi_epi32(a, b);
+    t3 = _mm256_unpackhi_epi32(c, d);
+    _mm256_storeu_si256((__m256i *) (out[0] + k), _mm256_permutevar8x32_epi32(r0, order));
+    _mm256_storeu_si256((__m256i *) (out[1] + k), _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi64(t0, t1), order));
+    _mm256_storeu_si256((__m256i *) (out[2] + k), _mm256_permutevar8x32_epi32(_mm256_unpacklo_epi64(t2, t3), order));
+    _mm256_storeu_si256((__m256i *) (out[3] + k), _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi64(t2, t3), order));
+    p += 128;
+  }
+  /* GCC leaves this out at -Os, which makes the SSE code afterwards slow. */
+  _mm256_zeroupper();
+  return k;
+}
+
+static int deinterleave_have_hardware(void)
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return 2;
+  if (__builtin_cpu_supports("ssse3")) return 1;
+  return 0;
+}
+#endif
+
+static int deinterleave4(const uint8_t *p, int count, int32_t *const *out)
+{
+  int32_t *rest[4];
+  int k = 0, c;
+#ifdef DEINTERLEAVE_HARDWARE
+  static int hardware = -1;
+  int level, n = 0;
+#endif
+
+#ifdef DEINTERLEAVE_HARDWARE
+  /* The decoders of kum_6d6_parallel may get here at the same time. */
+  level = __atomic_load_n(&hardware, __ATOMIC_RELAXED);
+  if (level < 0) {
+    level = deinterleave_have_hardware();
+    __atomic_store_n(&hardware, level, __ATOMIC_RELAXED);
+  }
+  if (level == 2) k = deinterleave4_avx2(p, count, out);
+  for (c = 0; c < 4; ++c) {
+    rest[c] = out[c] + k;
+  }
+  if (level >= 1) n = deinterleave4_ssse3(p + 16 * k, count - k, rest);
+  k += n;
+#endif
+  /* The frames in front of a control frame and the last few frames. */
+  for (c = 0; c < 4; ++c) {
+    rest[c] = out[c] + k;
+  }
+  return k + deinterleave4_generic(p + 16 * k, count - k, rest);
+}
+
+extern kum_6d6_deinterleave_kernel kum_6d6_deinterleave_select(int channel_count)
+{
+  static const kum_6d6_deinterleave_kernel kernels[] = {
+    deinterleave1, deinterleave2, deinterleave3, deinterleave4,
+    deinterleave5, deinterleave6, deinterleave7, deinterleave8
+  };
+
+  if (channel_count < 1 || channel_count > (int) (sizeof(kernels) / sizeof(*kernels))) return 0;
+  return kernels[channel_count - 1];
+}
+
+extern int kum_6d6_deinterleave(const uint8_t *p, int channel_count, int count, int32_t *const *out)
+{
+  kum_6d6_deinterleave_kernel kernel = kum_6d6_deinterleave_select(channel_count);
+  return kernel ? kernel(p, count, out) : 0;
+}
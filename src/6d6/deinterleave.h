@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Copy up to `count` sample frames of `channel_count` big endian words from
+ * `p` into one array per channel. Stops at the first control frame.
+ * Returns the number of sample frames copied. */
+extern int kum_6d6_deinterleave(const uint8_t *p, int channel_count, int count, int32_t *const *out);
+
+/* kum_6d6_deinterleave for a fixed channel count. */
+typedef int (*kum_6d6_deinterleave_kernel)(const uint8_t *p, int count, int32_t *const *out);
+
+/* Select the kernel for a channel count once, for example after reading the
+ * header. Returns 0 if there is no kernel for the channel count. */
+extern kum_6d6_deinterleave_kernel kum_6d6_deinterleave_select(int channel_count);
@@ -1,17 +1,25 @@
 #define _FILE_OFFSET_BITS 64
-#include <stdint.h>
-#include <stdio.h>
+#include "find_timestamp.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "decoder.h"
+#include "number.h"
+
+/* Control frames have the lowest bit of their first word set. */
+#define IS_CONTROL(p) ((p)[3] & 1)
+
+/* Bytes read at once while bisecting. Pieces overlap, so that a time frame
+ * at the end of one piece is found in the next. */
+#define BISECT_PIECE (64 * 1024)
+#define BISECT_OVERLAP 64
 
 static int read_i32_be(FILE *f, int32_t *i)
 {
-  int32_t t = 0;
-  int k, c;
+  uint8_t b[4];
   if (!f) return -1;
-  for (k = 0; k < 4; ++k) {
-    if ((c = fgetc(f)) == EOF) return -1;
-    t = ((t >> 8) & 0xffffff) | (c << 24);
-  }
-  if (i) *i = t;
+  if (fread(b, 4, 1, f) != 1) return -1;
+  if (i) *i = ld_i32_be(b);
   return 0;
 }
 
@@ -25,9 +33,12 @@ int find_timestamp(FILE *f, int64_t *t, int64_t *offset, int frame_border)
 {
   int32_t x;
   int state = frame_border ? data : r4;
+  int64_t position, frame = 0;
   if (!f) return -1;
+  position = ftello(f);
   while (1) {
     if (read_i32_be(f, &x)) return -1;
+    position += 4;
     switch (state) {
     case r1:
       state = (x & 1) ? r4 : data;
@@ -43,10 +54,11 @@ int find_timestamp(FILE *f, int64_t *t, int64_t *offset, int frame_border)
       break;
     case data:
       state = (x & 1) ? (x == 1 ? ts : other3) : data;
+      frame = position - 4;
       break;
     case ts:
       if (t) *t = x;
-      if (offset) *offset = ftell(f) - 8; /* XXX */
+      if (offset) *offset = frame;
       return 0;
     case other3:
       state = other2;
@@ -62,3 +74,119 @@ int find_timestamp(FILE *f, int64_t *t, int64_t *offset, int frame_border)
   }
   return -1;
 }
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define FIND_TIMESTAMP_SSE2
+#endif
+
+/* Offset of the first control frame at or after `i`, which must be at the
+ * beginning of a frame, or `length` if there is none. Between control frames
+ * there are only even words, so this is a search for the first odd word. */
+static size_t next_control(const uint8_t *p, size_t i, size_t length)
+{
+  static const uint8_t odd[8] = {0, 0, 0, 1, 0, 0, 0, 1};
+  uint64_t mask, x;
+
+#ifdef FIND_TIMESTAMP_SSE2
+  /* SSE2 is always there, 64 bytes per step keep up with memory. */
+  const __m128i low = _mm_set1_epi32(0x01000000);
+  __m128i v;
+
+  while (i + 64 <= length) {
+    v = _mm_or_si128(
+      _mm_or_si128(_mm_loadu_si128((const __m128i *) (p + i)), _mm_loadu_si128((const __m128i *) (p + i + 16))),
+      _mm_or_si128(_mm_loadu_si128((const __m128i *) (p + i + 32)), _mm_loadu_si128((const __m128i *) (p + i + 48))));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, low), _mm_setzero_si128())) != 0xffff) break;
+    i += 64;
+  }
+#endif
+  memcpy(&mask, odd, 8);
+  while (i + 8 <= length) {
+    memcpy(&x, p + i, 8);
+    if (x & mask) break;
+    i += 8;
+  }
+  while (i + 4 <= length && !IS_CONTROL(p + i)) {
+    i += 4;
+  }
+  return i + 4 <= length ? i : length;
+}
+
+extern size_t kum_6d6_next_control(const void *data, size_t length)
+{
+  return next_control(data, 0, length);
+}
+
+extern int64_t kum_6d6_find_timestamps(const void *data, size_t length, int frame_border, kum_6d6_timestamp *found, int64_t max)
+{
+  const uint8_t *p = data;
+  size_t i = 0;
+  int even = frame_border ? 4 : 0;
+  int64_t n = 0;
+
+  /* After four even words the next odd word starts a control frame. */
+  while (even < 4 && i + 4 <= length) {
+    even = IS_CONTROL(p + i) ? 0 : even + 1;
+    i += 4;
+  }
+  while (n < max && (i = next_control(p, i, length)) + 16 <= length) {
+    if (ld_i32_be(p + i) == KUM_6D6_TIME) {
+      found[n].offset = i;
+      found[n].time = ld_i32_be(p + i + 4) * (int64_t) 1000000 + ld_i32_be(p + i + 8);
+      ++n;
+    }
+    i += 16;
+  }
+  return n;
+}
+
+/* Find the first time frame between `from` and `to`. */
+static int bisect_probe(FILE *f, int64_t position, int64_t from, int64_t to, int frame_border, uint8_t *buffer, kum_6d6_timestamp *found)
+{
+  size_t n;
+
+  while (from + 16 <= to) {
+    n = to - from < BISECT_PIECE ? to - from : BISECT_PIECE;
+    if (fseeko(f, position + from, SEEK_SET) || fread(buffer, n, 1, f) != 1) return -1;
+    if (kum_6d6_find_timestamps(buffer, n, frame_border, found, 1)) {
+      found->offset += from;
+      return 0;
+    }
+    if (from + (int64_t) n >= to) break;
+    from += n - BISECT_OVERLAP;
+    frame_border = 0;
+  }
+  return -1;
+}
+
+extern int kum_6d6_bisect(FILE *f, int64_t position, int64_t length, int64_t time, kum_6d6_timestamp *found)
+{
+  kum_6d6_timestamp probe;
+  uint8_t *buffer;
+  int64_t a = 0, b = length, m;
+  int r = -1;
+
+  if (!(buffer = malloc(BISECT_PIECE))) return -1;
+  /* The last time frame at or before `time` starts between a and b. A frame
+   * starts at a, but probes in the middle have to find the frames first and
+   * may miss a time frame right at their start. */
+  while (a < b) {
+    m = (a + (b - a) / 2) & ~(int64_t) 511;
+    if (m < a) m = a;
+    if (bisect_probe(f, position, m, b + 16 < length ? b + 16 : length, m == a, buffer, &probe) ||
+        probe.offset >= b) {
+      if (m == a) break;
+      b = m;
+    } else if (probe.time > time) {
+      if (m == a) break;
+      b = probe.offset;
+    } else {
+      *found = probe;
+      r = 0;
+      a = probe.offset + 16;
+    }
+  }
+  free(buffer);
+  return r;
+}
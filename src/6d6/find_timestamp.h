@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -9,3 +10,32 @@
  + Stores the time and offset in the supplied fields and returns zero unless
  + there was an error. */
 extern int find_timestamp(FILE *f, int64_t *t, int64_t *offset, int frame_border);
+
+/* A time frame found by kum_6d6_find_timestamps. */
+typedef struct {
+  /* Offset of the frame from the start of the buffer. */
+  int64_t offset;
+  /* Microseconds since the start time. */
+  int64_t time;
+} kum_6d6_timestamp;
+
+/* Find the first control frame in a buffer of 6d6 data, which must start at
+ * the beginning of a frame. Sample words are even, so this is the first odd
+ * word. Returns its offset or `length` if there is none. */
+extern size_t kum_6d6_next_control(const void *data, size_t length);
+
+/* Find the time frames in a buffer of 6d6 data.
+ * Pass frame_border = 1 if the buffer starts at the beginning of a frame.
+ * Otherwise the frames are found first, which takes four sample words.
+ * Stores up to `max` timestamps in `found` and returns their number. To
+ * continue after the last one, search again from its offset + 16 with
+ * frame_border = 1. */
+extern int64_t kum_6d6_find_timestamps(const void *data, size_t length, int frame_border, kum_6d6_timestamp *found, int64_t max);
+
+/* Find the last time frame at or before `time`, in microseconds since the
+ * start time, by bisecting the `length` bytes of data at `position` in `f`.
+ * Reads a few small pieces of the data instead of all of it. A time frame
+ * right where a piece starts can be missed, then the one before is found.
+ * Stores the time frame in `found` with its offset from `position` and
+ * returns 0, or returns -1 if there is none or on I/O errors. */
+extern int kum_6d6_bisect(FILE *f, int64_t position, int64_t length, int64_t time, kum_6d6_timestamp *found);
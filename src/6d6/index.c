@@ -0,0 +1,178 @@
+#define _FILE_OFFSET_BITS 64
+#include "index.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "decoder.h"
+#include "number.h"
+
+#define INDEX_MAGIC "6D6I"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_LENGTH 40
+#define INDEX_ENTRY_LENGTH 24
+#define INDEX_BUFFER (1024 * 1024)
+
+static int index_add(kum_6d6_index *x, const kum_6d6_event *event)
+{
+  kum_6d6_index_entry *entries;
+  int64_t capacity;
+
+  if (x->time_frames++ % KUM_6D6_INDEX_STRIDE) return 0;
+  if (x->count == x->capacity) {
+    capacity = x->capacity ? 2 * x->capacity : 1024;
+    if (!(entries = realloc(x->entries, capacity * sizeof(*entries)))) return -1;
+    x->entries = entries;
+    x->capacity = capacity;
+  }
+  x->entries[x->count].offset = event->offset;
+  x->entries[x->count].sample_number = event->sample_number;
+  x->entries[x->count].time = event->time;
+  x->count += 1;
+  return 0;
+}
+
+extern void kum_6d6_index_init(kum_6d6_index *x, const kum_6d6_header *start, const kum_6d6_header *end)
+{
+  memset(x, 0, sizeof(*x));
+  memcpy(x->start_time, start->start_time, 6);
+  x->start_address = start->address;
+  x->end_address = end->address;
+  x->sample_rate = start->sample_rate;
+  x->channel_count = start->channel_count;
+}
+
+extern void kum_6d6_index_free(kum_6d6_index *x)
+{
+  free(x->entries);
+  x->entries = 0;
+  x->count = x->capacity = x->time_frames = 0;
+}
+
+extern int kum_6d6_index_build(kum_6d6_index *x, FILE *f, int64_t position, int64_t length)
+{
+  kum_6d6_decoder decoder[1];
+  uint8_t *buffer;
+  size_t n;
+  int e, r = -1;
+
+  if (kum_6d6_decoder_init(decoder, x->channel_count)) return -1;
+  if (!(buffer = malloc(INDEX_BUFFER))) return -1;
+  if (fseeko(f, position, SEEK_SET)) goto done;
+  x->count = x->time_frames = 0;
+  while (length > 0) {
+    n = length < INDEX_BUFFER ? length : INDEX_BUFFER;
+    if (fread(buffer, n, 1, f) != 1) goto done;
+    length -= n;
+    kum_6d6_decoder_feed(decoder, buffer, n);
+    while ((e = kum_6d6_decoder_next(decoder)) != KUM_6D6_DECODER_NEED_DATA) {
+      if (e != KUM_6D6_DECODER_EVENT) continue;
+      if (decoder->event.type == KUM_6D6_END) length = 0;
+      if (decoder->event.type == KUM_6D6_TIME && index_add(x, &decoder->event)) goto done;
+    }
+  }
+  r = 0;
+done:
+  free(buffer);
+  return r;
+}
+
+extern int kum_6d6_index_read(kum_6d6_index *x, const char *path)
+{
+  uint8_t h[INDEX_HEADER_LENGTH], e[INDEX_ENTRY_LENGTH];
+  kum_6d6_index_entry *entries = 0;
+  FILE *f;
+  int64_t count, k;
+
+  if (!(f = fopen(path, "rb"))) return -1;
+  if (fread(h, sizeof(h), 1, f) != 1 ||
+      memcmp(h, INDEX_MAGIC, 4) ||
+      ld_u32_be(h + 4) != INDEX_VERSION ||
+      memcmp(h + 8, x->start_time, 6) ||
+      ld_u32_be(h + 16) != x->start_address ||
+      ld_u32_be(h + 20) != x->end_address ||
+      ld_u16_be(h + 24) != x->sample_rate ||
+      ld_u16_be(h + 26) != x->channel_count ||
+      ld_u32_be(h + 28) != KUM_6D6_INDEX_STRIDE) goto fail;
+  /* A recording has less than 2^32 blocks, each with at most 32 frames. */
+  count = ld_i64_be(h + 32);
+  if (count < 0 || count > ((int64_t) 1 << 37) / KUM_6D6_INDEX_STRIDE) goto fail;
+  if (count && !(entries = malloc(count * sizeof(*entries)))) goto fail;
+  for (k = 0; k < count; ++k) {
+    if (fread(e, sizeof(e), 1, f) != 1) goto fail;
+    entries[k].offset = ld_i64_be(e);
+    entries[k].sample_number = ld_i64_be(e + 8);
+    entries[k].time = ld_i64_be(e + 16);
+  }
+  fclose(f);
+  kum_6d6_index_free(x);
+  x->entries = entries;
+  x->count = x->capacity = count;
+  return 0;
+fail:
+  free(entries);
+  fclose(f);
+  return -1;
+}
+
+extern int kum_6d6_index_write(const kum_6d6_index *x, const char *path)
+{
+  uint8_t h[INDEX_HEADER_LENGTH] = {0}, e[INDEX_ENTRY_LENGTH];
+  FILE *f;
+  int64_t k;
+
+  if (!(f = fopen(path, "wb"))) return -1;
+  memcpy(h, INDEX_MAGIC, 4);
+  st_u32_be(h + 4, INDEX_VERSION);
+  memcpy(h + 8, x->start_time, 6);
+  st_u32_be(h + 16, x->start_address);
+  st_u32_be(h + 20, x->end_address);
+  st_u16_be(h + 24, x->sample_rate);
+  st_u16_be(h + 26, x->channel_count);
+  st_u32_be(h + 28, KUM_6D6_INDEX_STRIDE);
+  st_i64_be(h + 32, x->count);
+  if (fwrite(h, sizeof(h), 1, f) != 1) goto fail;
+  for (k = 0; k < x->count; ++k) {
+    st_i64_be(e, x->entries[k].offset);
+    st_i64_be(e + 8, x->entries[k].sample_number);
+    st_i64_be(e + 16, x->entries[k].time);
+    if (fwrite(e, sizeof(e), 1, f) != 1) goto fail;
+  }
+  if (fclose(f)) {
+    remove(path);
+    return -1;
+  }
+  return 0;
+fail:
+  fclose(f);
+  remove(path);
+  return -1;
+}
+
+extern const kum_6d6_index_entry *kum_6d6_index_find(const kum_6d6_index *x, int64_t time)
+{
+  int64_t a = 0, b = x->count, m;
+
+  /* The first entry after `time` is at b. */
+  while (a < b) {
+    m = a + (b - a) / 2;
+    if (x->entries[m].time <= time) a = m + 1;
+    else b = m;
+  }
+  return b ? &x->entries[b - 1] : 0;
+}
+
+extern char *kum_6d6_index_path(const char *filename)
+{
+  size_t l = strlen(filename);
+  int ext = l >= 4 && !strcmp(filename + l - 4, ".6d6");
+  char *path;
+  struct stat st;
+
+  /* The index of a StiK or SD card would end up in /dev. */
+  if (!stat(filename, &st) && (S_ISBLK(st.st_mode) || S_ISCHR(st.st_mode))) return 0;
+  if (!(path = malloc(l + 8))) return 0;
+  memcpy(path, filename, l);
+  strcpy(path + l, ext ? "idx" : ".6d6idx");
+  return path;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "6d6.h"
+
+/* Every this many time frames are kept in an index. */
+#define KUM_6D6_INDEX_STRIDE 256
+
+/* Seek this far before the time wanted. This covers the skew of the clock,
+ * which is not known before decoding. */
+#define KUM_6D6_SEEK_MARGIN (600 * (int64_t) 1000000)
+
+typedef struct {
+  /* Offset of the time frame from the start of the data. */
+  int64_t offset;
+  /* Number of sample frames before it. */
+  int64_t sample_number;
+  /* Microseconds since the start time. */
+  int64_t time;
+} kum_6d6_index_entry;
+
+/* The offsets of every KUM_6D6_INDEX_STRIDE-th time frame of a recording.
+ * An index is stored next to the recording with kum_6d6_index_write and is
+ * only loaded again for the same recording. */
+typedef struct {
+  /* The recording the index belongs to. */
+  uint8_t start_time[6];
+  uint32_t start_address, end_address;
+  int sample_rate, channel_count;
+  kum_6d6_index_entry *entries;
+  int64_t count;
+
+  /* Private. */
+  int64_t capacity, time_frames;
+} kum_6d6_index;
+
+/* Prepare an empty index for the recording with the given headers. */
+extern void kum_6d6_index_init(kum_6d6_index *index, const kum_6d6_header *start_header, const kum_6d6_header *end_header);
+
+/* Release the entries of an index. */
+extern void kum_6d6_index_free(kum_6d6_index *index);
+
+/* Build the index by decoding `length` bytes of data at `position` in `f`.
+ * Returns 0 on success and -1 on I/O errors or if memory is short. */
+extern int kum_6d6_index_build(kum_6d6_index *index, FILE *f, int64_t position, int64_t length);
+
+/* Load the index from `path`.
+ * Returns 0 on success and -1 if there is no index for the recording. */
+extern int kum_6d6_index_read(kum_6d6_index *index, const char *path);
+
+/* Save the index to `path`.
+ * Returns 0 on success and -1 on failure. */
+extern int kum_6d6_index_write(const kum_6d6_index *index, const char *path);
+
+/* Find the last entry at or before `time`, in microseconds since the start
+ * time. Returns 0 if there is none. */
+extern const kum_6d6_index_entry *kum_6d6_index_find(const kum_6d6_index *index, int64_t time);
+
+/* The path of the index of the recording in `filename`: 'x.6d6' becomes
+ * 'x.6d6idx', other names get '.6d6idx' appended. Free it when done.
+ * Returns 0 for devices, whose index needs a path of its own. */
+extern char *kum_6d6_index_path(const char *filename);
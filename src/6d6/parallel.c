@@ -0,0 +1,274 @@
+#include "parallel.h"
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Smaller parts are not worth a thread. */
+#define PARALLEL_MIN_PART (64 * 1024)
+
+typedef struct {
+  int type, count;
+  /* Index into the samples or the events of the part. */
+  int64_t index;
+} parallel_item;
+
+typedef struct {
+  kum_6d6_decoder decoder;
+  const uint8_t *data;
+  size_t length;
+  /* What the decoder returned, in order. */
+  parallel_item *items;
+  int64_t item_count, item_capacity;
+  int32_t *samples[KUM_6D6_MAX_CHANNEL_COUNT];
+  int64_t sample_count, sample_capacity;
+  kum_6d6_event *events;
+  int64_t event_count, event_capacity;
+  int failed;
+} parallel_part;
+
+struct kum_6d6_parallel {
+  int channel_count, threads;
+  /* The decoder of the first part carries frames from buffer to buffer. */
+  parallel_part *parts;
+  /* Decodes all parts but the first. */
+  kum_6d6_pool *pool;
+  /* The first decoder before the last buffer, to decode it again if the
+   * parts did not fit together. */
+  kum_6d6_decoder saved;
+  /* A buffer in one part is decoded by kum_6d6_parallel_next. */
+  int direct;
+  kum_6d6_result *results;
+  int64_t result_count, result_capacity;
+};
+
+static int grow(void **x, int64_t *capacity, int64_t need, size_t size)
+{
+  int64_t n = *capacity ? *capacity : 256;
+  void *y;
+
+  if (need <= *capacity) return 0;
+  while (n < need) {
+    n *= 2;
+  }
+  if (!(y = realloc(*x, n * size))) return -1;
+  *x = y;
+  *capacity = n;
+  return 0;
+}
+
+static int grow_samples(parallel_part *q, int64_t need)
+{
+  int64_t capacity;
+  int c;
+
+  for (c = 0; c < q->decoder.channel_count; ++c) {
+    capacity = q->sample_capacity;
+    if (grow((void **) &q->samples[c], &capacity, need, sizeof(int32_t))) return -1;
+  }
+  q->sample_capacity = capacity;
+  return 0;
+}
+
+static void *decode_part(void *x)
+{
+  parallel_part *q = x;
+  kum_6d6_decoder *d = &q->decoder;
+  parallel_item *item;
+  int c, e;
+
+  q->item_count = q->sample_count = q->event_count = 0;
+  q->failed = 0;
+  kum_6d6_decoder_feed(d, q->data, q->length);
+  while ((e = kum_6d6_decoder_next(d)) != KUM_6D6_DECODER_NEED_DATA) {
+    if (grow((void **) &q->items, &q->item_capacity, q->item_count + 1, sizeof(*q->items))) goto fail;
+    item = &q->items[q->item_count++];
+    item->type = e;
+    item->count = 0;
+    if (e == KUM_6D6_DECODER_SAMPLES) {
+      if (grow_samples(q, q->sample_count + d->count)) goto fail;
+      for (c = 0; c < d->channel_count; ++c) {
+        memcpy(q->samples[c] + q->sample_count, d->samples[c], d->count * sizeof(int32_t));
+      }
+      item->count = d->count;
+      item->index = q->sample_count;
+      q->sample_count += d->count;
+    } else {
+      if (grow((void **) &q->events, &q->event_capacity, q->event_count + 1, sizeof(*q->events))) goto fail;
+      q->events[q->event_count] = d->event;
+      item->index = q->event_count++;
+    }
+  }
+  return 0;
+fail:
+  q->failed = 1;
+  return 0;
+}
+
+extern kum_6d6_parallel *kum_6d6_parallel_new(int channel_count, int threads)
+{
+  kum_6d6_parallel *p;
+
+  if (threads < 1) threads = 1;
+  if (!(p = calloc(1, sizeof(*p)))) return 0;
+  p->channel_count = channel_count;
+  p->threads = threads;
+  p->parts = calloc(threads, sizeof(*p->parts));
+  if (!p->parts || kum_6d6_decoder_init(&p->parts[0].decoder, channel_count) ||
+      grow((void **) &p->results, &p->result_capacity, 1, sizeof(*p->results)) ||
+      !(p->pool = kum_6d6_pool_new(threads - 1, decode_part, &p->parts[1], sizeof(*p->parts)))) {
+    kum_6d6_parallel_destroy(p);
+    return 0;
+  }
+  return p;
+}
+
+extern int kum_6d6_parallel_feed(kum_6d6_parallel *p, const void *data, size_t length)
+{
+  const uint8_t *b = data;
+  kum_6d6_decoder *first = &p->parts[0].decoder, *last;
+  parallel_part *q;
+  kum_6d6_result *r;
+  int64_t count, sample_number, x, j;
+  size_t from;
+  int n = 1, parts, k, c;
+
+  /* Split the buffer at the first time frame after every share. */
+  parts = length / PARALLEL_MIN_PART < (size_t) p->threads ? length / PARALLEL_MIN_PART : p->threads;
+  p->parts[0].data = b;
+  for (k = 1; k < parts; ++k) {
+    from = length / parts * k & ~(size_t) 3;
+    if (from <= (size_t) (p->parts[n - 1].data - b)) from = p->parts[n - 1].data - b + 4;
+    if (from >= length || (x = kum_6d6_resync(b + from, length - from)) < 0) break;
+    p->parts[n++].data = b + from + x;
+  }
+  for (k = 0; k < n; ++k) {
+    p->parts[k].length = (k + 1 < n ? p->parts[k + 1].data : b + length) - p->parts[k].data;
+  }
+
+  p->result_count = 0;
+  p->direct = 0;
+  if (n == 1) goto direct;
+
+  /* Decode the parts, the first one on this thread. */
+  p->saved = *first;
+  for (k = 1; k < n; ++k) {
+    q = &p->parts[k];
+    kum_6d6_decoder_init(&q->decoder, p->channel_count);
+    q->decoder.offset = first->offset + (q->data - b);
+  }
+  kum_6d6_pool_start(p->pool, n - 1);
+  decode_part(&p->parts[0]);
+  kum_6d6_pool_wait(p->pool);
+
+  /* Every part but the last has to end with a whole frame. Otherwise the
+   * data is broken in a way which the time frames did not show, and the
+   * buffer is decoded again in one piece. */
+  for (k = 0; k + 1 < n; ++k) {
+    if (p->parts[k].decoder.partial_length) break;
+  }
+  if (k + 1 < n) {
+    *first = p->saved;
+    goto direct;
+  }
+  for (k = 0; k < n; ++k) {
+    if (p->parts[k].failed) return -1;
+  }
+
+  /* The decoders of the later parts started counting at zero. */
+  sample_number = first->sample_number;
+  for (k = 1; k < n; ++k) {
+    q = &p->parts[k];
+    for (j = 0; j < q->event_count; ++j) {
+      q->events[j].sample_number += sample_number;
+    }
+    sample_number += q->decoder.sample_number;
+  }
+  last = &p->parts[n - 1].decoder;
+  memcpy(first->partial, last->partial, last->partial_length);
+  first->partial_length = last->partial_length;
+  first->offset = last->offset;
+  first->sample_number = sample_number;
+
+  /* Put the results of all parts in order. */
+  count = 0;
+  for (k = 0; k < n; ++k) {
+    count += p->parts[k].item_count;
+  }
+  if (grow((void **) &p->results, &p->result_capacity, count, sizeof(*p->results))) return -1;
+  r = p->results;
+  for (k = 0; k < n; ++k) {
+    q = &p->parts[k];
+    for (j = 0; j < q->item_count; ++j, ++r) {
+      r->type = q->items[j].type;
+      r->count = q->items[j].count;
+      r->event = 0;
+      if (r->type == KUM_6D6_DECODER_SAMPLES) {
+        for (c = 0; c < p->channel_count; ++c) {
+          r->samples[c] = q->samples[c] + q->items[j].index;
+        }
+      } else {
+        r->event = q->events + q->items[j].index;
+      }
+    }
+  }
+  p->result_count = count;
+  return 0;
+
+direct:
+  /* A single part is not copied, kum_6d6_parallel_next hands out the
+   * results of the decoder as they come. */
+  kum_6d6_decoder_feed(first, b, length);
+  p->direct = 1;
+  return 0;
+}
+
+extern int64_t kum_6d6_parallel_next(kum_6d6_parallel *p, const kum_6d6_result **results)
+{
+  kum_6d6_decoder *d = &p->parts[0].decoder;
+  kum_6d6_result *r = p->results;
+  int64_t count;
+  int c;
+
+  *results = r;
+  if (!p->direct) {
+    count = p->result_count;
+    p->result_count = 0;
+    return count;
+  }
+  if ((r->type = kum_6d6_decoder_next(d)) == KUM_6D6_DECODER_NEED_DATA) {
+    p->direct = 0;
+    return 0;
+  }
+  r->count = 0;
+  r->event = 0;
+  if (r->type == KUM_6D6_DECODER_SAMPLES) {
+    r->count = d->count;
+    for (c = 0; c < d->channel_count; ++c) {
+      r->samples[c] = d->samples[c];
+    }
+  } else {
+    r->event = &d->event;
+  }
+  return 1;
+}
+
+extern void kum_6d6_parallel_destroy(kum_6d6_parallel *p)
+{
+  int k, c;
+
+  if (!p) return;
+  kum_6d6_pool_destroy(p->pool);
+  if (p->parts) {
+    for (k = 0; k < p->threads; ++k) {
+      free(p->parts[k].items);
+      free(p->parts[k].events);
+      for (c = 0; c < KUM_6D6_MAX_CHANNEL_COUNT; ++c) {
+        free(p->parts[k].samples[c]);
+      }
+    }
+  }
+  free(p->parts);
+  free(p->results);
+  free(p);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "decoder.h"
+
+/* A result of kum_6d6_parallel_next. The results come in the order of the
+ * data, exactly as kum_6d6_decoder_next would have returned them. */
+typedef struct {
+  /* KUM_6D6_DECODER_SAMPLES or KUM_6D6_DECODER_EVENT. */
+  int type;
+  /* KUM_6D6_DECODER_SAMPLES: `count` sample frames, one array per channel. */
+  int count;
+  const int32_t *samples[KUM_6D6_MAX_CHANNEL_COUNT];
+  /* KUM_6D6_DECODER_EVENT: The control frame. */
+  const kum_6d6_event *event;
+} kum_6d6_result;
+
+/* Decodes large buffers on several threads.
+ * Every buffer is split into parts which start at a time frame, where the
+ * frames can be found without decoding what comes before. The parts are
+ * decoded at the same time and their results are put back in order. Frames
+ * may still cross buffers. */
+typedef struct kum_6d6_parallel kum_6d6_parallel;
+
+/* Create a decoder for the given number of channels which uses up to
+ * `threads` threads. Returns 0 if the channel count is invalid or there is
+ * not enough memory. */
+extern kum_6d6_parallel *kum_6d6_parallel_new(int channel_count, int threads);
+
+/* Decode the next buffer. The buffer must stay valid until
+ * kum_6d6_parallel_next returns 0.
+ * Returns 0 on success or -1 if there is not enough memory. */
+extern int kum_6d6_parallel_feed(kum_6d6_parallel *p, const void *data, size_t length);
+
+/* Get the next results of the buffer. If it was decoded in parts, all
+ * results come at once. A buffer in one part is decoded here and its
+ * results come one at a time, straight from the decoder. The results stay
+ * valid until the next call.
+ * Returns the number of results or 0 once the buffer is used up. */
+extern int64_t kum_6d6_parallel_next(kum_6d6_parallel *p, const kum_6d6_result **results);
+
+extern void kum_6d6_parallel_destroy(kum_6d6_parallel *p);
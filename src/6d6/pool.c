@@ -0,0 +1,120 @@
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+  kum_6d6_pool *pool;
+  int index;
+  pthread_t thread;
+} pool_thread;
+
+struct kum_6d6_pool {
+  void *(*run)(void *);
+  char *args;
+  size_t size;
+  pool_thread *threads;
+  int thread_count;
+  pthread_mutex_t lock[1];
+  pthread_cond_t start[1], done[1];
+  /* Counts the rounds, so a thread notices a new one. */
+  int64_t round;
+  /* Threads which work in this round and those which are not done yet. */
+  int count, busy;
+  int stop;
+};
+
+static void *pool_run(void *x)
+{
+  pool_thread *t = x;
+  kum_6d6_pool *p = t->pool;
+  int64_t round = 0;
+
+  pthread_mutex_lock(p->lock);
+  for (;;) {
+    while (p->round == round && !p->stop) {
+      pthread_cond_wait(p->start, p->lock);
+    }
+    if (p->stop) break;
+    round = p->round;
+    if (t->index >= p->count) continue;
+    pthread_mutex_unlock(p->lock);
+    p->run(p->args + t->index * p->size);
+    pthread_mutex_lock(p->lock);
+    if (--p->busy == 0) pthread_cond_signal(p->done);
+  }
+  pthread_mutex_unlock(p->lock);
+  return 0;
+}
+
+extern kum_6d6_pool *kum_6d6_pool_new(int threads, void *(*run)(void *), void *args, size_t size)
+{
+  kum_6d6_pool *p;
+
+  if (threads < 0) threads = 0;
+  if (!(p = calloc(1, sizeof(*p)))) return 0;
+  if (!(p->threads = calloc(threads ? threads : 1, sizeof(*p->threads)))) {
+    free(p);
+    return 0;
+  }
+  p->run = run;
+  p->args = args;
+  p->size = size;
+  pthread_mutex_init(p->lock, 0);
+  pthread_cond_init(p->start, 0);
+  pthread_cond_init(p->done, 0);
+  for (p->thread_count = 0; p->thread_count < threads; ++p->thread_count) {
+    p->threads[p->thread_count].pool = p;
+    p->threads[p->thread_count].index = p->thread_count;
+    if (pthread_create(&p->threads[p->thread_count].thread, 0, pool_run, &p->threads[p->thread_count])) break;
+  }
+  return p;
+}
+
+extern void kum_6d6_pool_start(kum_6d6_pool *p, int count)
+{
+  pthread_mutex_lock(p->lock);
+  p->count = count;
+  if (count > 0) {
+    p->busy = count < p->thread_count ? count : p->thread_count;
+    p->round += 1;
+    pthread_cond_broadcast(p->start);
+  }
+  pthread_mutex_unlock(p->lock);
+}
+
+extern void kum_6d6_pool_wait(kum_6d6_pool *p)
+{
+  int k;
+
+  if (p->count < 1) return;
+  /* The work of threads which could not be started. */
+  for (k = p->thread_count; k < p->count; ++k) {
+    p->run(p->args + k * p->size);
+  }
+  pthread_mutex_lock(p->lock);
+  while (p->busy) {
+    pthread_cond_wait(p->done, p->lock);
+  }
+  pthread_mutex_unlock(p->lock);
+}
+
+extern void kum_6d6_pool_destroy(kum_6d6_pool *p)
+{
+  int k;
+
+  if (!p) return;
+  pthread_mutex_lock(p->lock);
+  p->stop = 1;
+  pthread_cond_broadcast(p->start);
+  pthread_mutex_unlock(p->lock);
+  for (k = 0; k < p->thread_count; ++k) {
+    pthread_join(p->threads[k].thread, 0);
+  }
+  pthread_cond_destroy(p->done);
+  pthread_cond_destroy(p->start);
+  pthread_mutex_destroy(p->lock);
+  free(p->threads);
+  free(p);
+}
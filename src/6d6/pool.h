@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+
+/* A fixed set of threads which do one piece of work each per round, for
+ * work which comes in rounds too small to start a thread for every piece.
+ * Thread k works on the k-th argument. The threads are synchronized with a
+ * lock and condition variables, as not every system has barriers. */
+typedef struct kum_6d6_pool kum_6d6_pool;
+
+/* Create a pool of `threads` threads, which may be 0. Thread k calls `run`
+ * with `args + k * size`. If not all threads can be started, the remaining
+ * work is done by kum_6d6_pool_wait.
+ * Returns 0 if there is not enough memory. */
+extern kum_6d6_pool *kum_6d6_pool_new(int threads, void *(*run)(void *), void *args, size_t size);
+
+/* Start a round in which the first `count` threads work. */
+extern void kum_6d6_pool_start(kum_6d6_pool *pool, int count);
+
+/* Wait until all work of the round is done. */
+extern void kum_6d6_pool_wait(kum_6d6_pool *pool);
+
+extern void kum_6d6_pool_destroy(kum_6d6_pool *pool);
@@ -1,11 +1,23 @@
 #define _FILE_OFFSET_BITS 64
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include <inttypes.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/sysmacros.h>
+#endif
 #include "6d6.h"
+#include "blockreader.h"
+#include "checksum.h"
 #include "options.h"
 #include "version.h"
 #include "i18n.h"
@@ -13,12 +25,40 @@
 #include "monotonic-time.h"
 
 const char *program = "6d6copy";
+
+/* Options for reading the input. */
+static int64_t chunk_size = BLOCKREADER_CHUNK_SIZE, queue_depth = 0;
+static int read_flags = 0;
+
+/* Options for writing the output. */
+static int drop_cache = 0, resume_copy = 0, manifest_algorithms = 0;
+static char *append_comment = 0;
+static int64_t bandwidth = 0;
+
+/* When several copies are made at once, each one reports its progress to the
+ * main process through shared memory. */
+enum {
+  COPY_WAITING,
+  COPY_RUNNING,
+  COPY_DONE,
+  COPY_FAILED
+};
+typedef struct {
+  int64_t done, total, started, finished;
+  int state;
+} copy_status;
+static copy_status *status = 0;
+
+/* The time at which the bandwidth limit allows the next bytes to be copied.
+ * It is shared by all copies. */
+static int64_t *bandwidth_clock = 0;
+
 static void help(const char *arg)
 {
   fprintf(stdout, i18n->version_ss,
     KUM_6D6_COMPAT_VERSION, KUM_6D6_COMPAT_DATE);
   fprintf(stdout, i18n->usage_6d6copy_s,
-    program);
+    program, program);
   exit(1);
 }
 
@@ -28,6 +68,17 @@ static void io_error(int x)
   exit(1);
 }
 
+/* Drop root privileges if we had any. */
+static void drop_privileges(void)
+{
+  uid_t uid = getuid();
+  gid_t gid = getgid();
+  if ((gid > 0 && setgid(gid) < 0) || (uid > 0 && setuid(uid) < 0)) {
+    fprintf(stderr, "%s", i18n->could_not_restore_uid);
+    exit(1);
+  }
+}
+
 static int append_string(char *s, const char *s2, size_t n)
 {
   size_t l1 = strlen(s);
@@ -61,122 +112,694 @@ static void unescape(char *s)
   s[w] = 0;
 }
 
-int main(int argc, char **argv)
+static void show_progress(int progress, int64_t n, int64_t end, int64_t t0, int64_t *t1)
+{
+  int64_t t;
+
+  if (status) {
+    __atomic_store_n(&status->done, n, __ATOMIC_RELAXED);
+    __atomic_store_n(&status->total, end, __ATOMIC_RELAXED);
+  }
+  if (progress == 1) {
+    fprintf(stderr, "%2$3d%% %1$6.1f MB        \r",
+      (double) n / 1000000,
+      (int) (100 * n / end));
+  } else if (progress == 2) {
+    t = monotonic_time();
+    if (t - *t1 >= monotonic_time_ms(50)) {
+      fprintf(stdout,
+        "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64"}\n",
+        n, end, (t - t0) * 50 / monotonic_time_ms(50), monotonic_throughput(n, t - t0));
+      fflush(stdout);
+      *t1 = t;
+    }
+  }
+}
+
+/* Wait until `bytes` more can be copied without exceeding the bandwidth
+ * limit. Every copy reserves its time on the shared clock. */
+static void throttle(int64_t bytes)
+{
+  int64_t now, start, next;
+  struct timespec delay;
+  double t;
+
+  if (!bandwidth) return;
+  now = monotonic_time();
+  next = __atomic_load_n(bandwidth_clock, __ATOMIC_RELAXED);
+  do {
+    start = next > now ? next : now;
+  } while (!__atomic_compare_exchange_n(bandwidth_clock, &next,
+    start + (int64_t) (bytes * (double) monotonic_time_ms(1000) / bandwidth),
+    0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  if (start > now) {
+    t = (start - now) / (double) monotonic_time_ms(1000);
+    delay.tv_sec = t;
+    delay.tv_nsec = (t - delay.tv_sec) * 1e9;
+    while (nanosleep(&delay, &delay) < 0 && errno == EINTR);
+  }
+}
+
+/* Reserve the space for the whole copy at once, so that the file system can
+ * keep it in few extents. On Linux and macOS the file size is not changed,
+ * so that an interrupted copy does not look complete. Errors are ignored, as
+ * not every file system supports this. */
+static void preallocate(int fd, int64_t length)
+{
+#if defined(__linux__)
+  fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, length);
+#elif defined(__APPLE__)
+  fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, length, 0};
+  if (fcntl(fd, F_PREALLOCATE, &store) < 0) {
+    store.fst_flags = F_ALLOCATEALL;
+    fcntl(fd, F_PREALLOCATE, &store);
+  }
+#else
+  posix_fallocate(fd, 0, length);
+#endif
+}
+
+/* Remove the output from the page cache once it is on the disk, so that
+ * copying many cards does not push everything else out of the cache.
+ * The writeback of the bytes from `from` to `to` is only started; they are
+ * dropped by the next call. `dropped` is the end of the part dropped so far. */
+static void drop_written(int fd, int64_t *dropped, int64_t from, int64_t to)
+{
+  if (!drop_cache) return;
+#if defined(__linux__)
+  sync_file_range(fd, from, to - from, SYNC_FILE_RANGE_WRITE);
+  if (*dropped < from) {
+    sync_file_range(fd, *dropped, from - *dropped,
+      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(fd, *dropped, from - *dropped, POSIX_FADV_DONTNEED);
+    *dropped = from;
+  }
+#endif
+}
+
+/* Drop everything which is still in the page cache after the copy. */
+static void drop_all(int fd)
+{
+  if (!drop_cache) return;
+  if (fsync(fd)) io_error(3);
+#ifdef POSIX_FADV_DONTNEED
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+/* Bytes copied by the kernel at once, so that the progress keeps moving. */
+#define COPY_CHUNK ((int64_t) 64 * 1024 * 1024)
+
+/* Copy `length` bytes from `offset` in the input to the current position of
+ * the output without moving them through user space. Where the file system
+ * supports it, copy_file_range shares the data with the input (reflink).
+ * Returns the number of bytes copied, which is 0 if the kernel can not copy
+ * between these files. */
+static int64_t copy_range(int in, int out, int64_t offset, int64_t length, int progress, int64_t t0, int64_t *t1)
+{
+  int64_t n = 0, m, dropped = 0;
+#ifdef __linux__
+  off_t position = offset;
+  ssize_t x;
+  int use_sendfile = 0;
+
+  while (n < length) {
+    m = length - n > COPY_CHUNK ? COPY_CHUNK : length - n;
+    /* Smaller steps keep the bandwidth limit smooth. */
+    if (bandwidth && m > chunk_size) m = chunk_size;
+    throttle(m);
+    if (!use_sendfile) {
+      x = copy_file_range(in, &position, out, 0, m, 0);
+      /* Block devices and older kernels need sendfile. */
+      if (x < 0 && n == 0 && errno != EINTR && errno != EIO) {
+        use_sendfile = 1;
+        continue;
+      }
+    } else {
+      x = sendfile(out, in, &position, m);
+    }
+    if (x < 0 && errno == EINTR) continue;
+    if (x <= 0) break;
+    drop_written(out, &dropped, n, n + x);
+    n += x;
+    show_progress(progress, n, length, t0, t1);
+  }
+#endif
+  return n;
+}
+
+/* Write the checksums of a copy to `filename`.manifest. */
+static void write_manifest(const char *filename, Checksum checksum, int algorithms)
+{
+  char name[4096], sha[65];
+  FILE *f;
+
+  snprintf(name, sizeof(name), "%s.manifest", filename);
+  if (!(f = fopen(name, "w"))) {
+    fprintf(stderr, i18n->could_not_open_ss, name, i18n_error(errno));
+    exit(1);
+  }
+  fprintf(f, "size %"PRId64"\n", checksum_length(checksum));
+  if (algorithms & CHECKSUM_CRC32C) {
+    fprintf(f, "crc32c %08"PRIx32"\n", checksum_crc32c(checksum));
+  }
+  if (algorithms & CHECKSUM_SHA256) {
+    checksum_sha256(checksum, sha);
+    fprintf(f, "sha256 %s\n", sha);
+  }
+  if (fclose(f)) io_error(4);
+}
+
+/* A checkpoint of a resumable copy: an offset in the copy and the CRC32C
+ * of all bytes before it. */
+typedef struct {
+  int64_t offset;
+  uint32_t crc;
+} checkpoint;
+
+/* Bytes copied between two checkpoints. */
+#define CHECKPOINT_INTERVAL ((int64_t) 256 * 1024 * 1024)
+
+/* Hash the first `length` bytes of a file.
+ * If checkpoints are given, the CRC32C is compared at every checkpoint and
+ * hashing stops at the first one which does not match. `count` is set to the
+ * number of matching checkpoints.
+ * Returns the number of bytes hashed. */
+static int64_t hash_file(FILE *f, int64_t length, Checksum checksum, const checkpoint *checkpoints, int64_t *count, int progress)
+{
+  Blockreader reader;
+  const uint8_t *data;
+  int64_t n = 0, m, k, i = 0, t0, t1;
+
+  if (!(reader = blockreader_open(f, 0, 0, 512, length / 512, chunk_size / 512, queue_depth, read_flags))) io_error(2);
+
+  t0 = t1 = monotonic_time();
+  while (n < length && (data = blockreader_get(reader))) {
+    m = blockreader_length(reader);
+    /* Split the chunk at the checkpoints. */
+    while (m > 0) {
+      k = count && i < *count && checkpoints[i].offset - n < m ? checkpoints[i].offset - n : m;
+      checksum_update(checksum, data, k);
+      data += k;
+      n += k;
+      m -= k;
+      if (count && i < *count && checkpoints[i].offset == n) {
+        if (checksum_crc32c(checksum) != checkpoints[i].crc) goto done;
+        i += 1;
+      }
+    }
+    show_progress(progress, n, length, t0, &t1);
+  }
+done:
+  blockreader_destroy(reader);
+
+  if (count) *count = i;
+  return n;
+}
+
+/* Find out how much of an earlier copy to `filename` can be kept.
+ * The copy has to start with the same `header` and must match its
+ * checkpoints. The part which is kept is hashed into `checksum` and the
+ * checkpoint file is opened for new checkpoints.
+ * Returns the number of bytes to keep. */
+static int64_t resume(FILE *outfile, const char *filename, const char *header, int64_t end, Checksum *checksum, int algorithms, FILE **checkpoint_file)
+{
+  char name[4096], line[256], old_header[1024];
+  checkpoint *checkpoints = 0, *c;
+  int64_t count = 0, good = 0, n = 0, i;
+  FILE *f;
+
+  snprintf(name, sizeof(name), "%s.checkpoint", filename);
+  if ((f = fopen(name, "r"))) {
+    while (fgets(line, sizeof(line), f)) {
+      if (!(c = realloc(checkpoints, (count + 1) * sizeof(checkpoint)))) io_error(5);
+      checkpoints = c;
+      if (sscanf(line, "%"SCNd64" %8"SCNx32, &c[count].offset, &c[count].crc) != 2) break;
+      if (c[count].offset <= (count ? c[count - 1].offset : 0) || c[count].offset % 512) break;
+      /* Checkpoints behind the end belong to a longer recording. */
+      if (c[count].offset > end) break;
+      count += 1;
+    }
+    fclose(f);
+  }
+
+  /* The copy must belong to the same recording. */
+  if (count && (pread(fileno(outfile), old_header, sizeof(old_header), 0) != sizeof(old_header) ||
+      memcmp(old_header, header, sizeof(old_header)))) {
+    count = 0;
+  }
+
+  if (count) {
+    n = hash_file(outfile, checkpoints[count - 1].offset, *checksum, checkpoints, &count, 0);
+    good = count ? checkpoints[count - 1].offset : 0;
+  }
+  if (n != good) {
+    /* Something behind the last good checkpoint was hashed already. */
+    checksum_destroy(*checksum);
+    if (!(*checksum = checksum_new(algorithms))) io_error(5);
+    hash_file(outfile, good, *checksum, 0, 0, 0);
+  }
+
+  /* Only keep the good checkpoints. */
+  if (!(*checkpoint_file = fopen(name, "w"))) {
+    fprintf(stderr, i18n->could_not_open_ss, name, i18n_error(errno));
+    exit(1);
+  }
+  for (i = 0; i < count; ++i) {
+    fprintf(*checkpoint_file, "%"PRId64" %08"PRIx32"\n", checkpoints[i].offset, checkpoints[i].crc);
+  }
+  if (fflush(*checkpoint_file)) io_error(4);
+  free(checkpoints);
+
+  return good;
+}
+
+/* Read the file again and compare it against its manifest.
+ * Returns 0 if the file matches. */
+static int verify(const char *filename, int progress)
+{
+  char name[4096], line[256], sha[65], expected_sha[65] = "";
+  uint32_t crc = 0;
+  int64_t size = -1, n, t0, t;
+  int algorithms = 0, ok;
+  struct stat st;
+  FILE *f;
+  Checksum checksum;
+
+  snprintf(name, sizeof(name), "%s.manifest", filename);
+  if (!(f = fopen(name, "r"))) {
+    fprintf(stderr, i18n->could_not_open_ss, name, i18n_error(errno));
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "size %"SCNd64, &size) == 1) continue;
+    if (sscanf(line, "crc32c %8"SCNx32, &crc) == 1) algorithms |= CHECKSUM_CRC32C;
+    if (sscanf(line, "sha256 %64[0-9a-f]", expected_sha) == 1) algorithms |= CHECKSUM_SHA256;
+  }
+  fclose(f);
+  if (size < 0 || size % 512 || !algorithms) {
+    fprintf(stderr, i18n->invalid_manifest_s, name);
+    exit(1);
+  }
+
+  if (!(f = fopen(filename, "rb"))) {
+    fprintf(stderr, i18n->could_not_open_ss, filename, i18n_error(errno));
+    exit(1);
+  }
+  if (!(checksum = checksum_new(algorithms))) io_error(5);
+
+  t0 = monotonic_time();
+  n = hash_file(f, size, checksum, 0, 0, progress);
+
+  if (progress == 1) {
+    fprintf(stderr, "%2$3d%% %1$6.1f MB        \n", (double) n / 1000000, (int) (size ? 100 * n / size : 100));
+  } else if (progress == 2) {
+    t = monotonic_time();
+    fprintf(stdout,
+          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64"}\n",
+          n, size, (t - t0) * 50 / monotonic_time_ms(50), monotonic_throughput(n, t - t0));
+    fflush(stdout);
+  }
+
+  ok = n == size && fstat(fileno(f), &st) == 0 && st.st_size == size;
+  if (algorithms & CHECKSUM_CRC32C) ok = ok && checksum_crc32c(checksum) == crc;
+  if (algorithms & CHECKSUM_SHA256) {
+    checksum_sha256(checksum, sha);
+    ok = ok && strcmp(sha, expected_sha) == 0;
+  }
+  checksum_destroy(checksum);
+  fclose(f);
+
+  fprintf(ok ? stdout : stderr, ok ? i18n->verify_ok_s : i18n->verify_failed_s, filename);
+  return ok ? 0 : 1;
+}
+
+/* Copy the recording in `input` to `output`.
+ * Any error ends the process. */
+static int copy(const char *input, const char *output, int progress)
 {
   FILE *infile, *outfile;
   int64_t l, m, n, end;
-  char buffer[1024*128];
+  char buffer[1024*128 + 512];
   kum_6d6_header start_header[1], end_header[1];
-  int offset = 0, e, progress = 1;
-  char *append_comment = 0;
-  int64_t t0, t1, t, _50ms;
-
-  i18n_set_lang(getenv("LANG"));
-
-  program = argv[0];
-  parse_options(&argc, &argv, OPTIONS(
-    FLAG('p', "progress", progress, 1),
-    FLAG('q', "no-progress", progress, 0),
-    FLAG(0, "json-progress", progress, 2),
-    PARAMETER(0, "append-comment", append_comment),
-    FLAG_CALLBACK('h', "help", help)
-  ));
+  int offset = 0, e;
+  Checksum checksum = 0;
+  FILE *checkpoints = 0;
+  int64_t position, last_checkpoint, dropped = 0;
+  char name[4096];
+  Blockreader reader;
+  const uint8_t *data;
+  int64_t t0, t1, t;
 
-  if (argc != 3) help(0);
+  /* The checkpoints need the CRC32C. */
+  if ((manifest_algorithms || resume_copy) && !(checksum = checksum_new(manifest_algorithms | CHECKSUM_CRC32C))) io_error(5);
 
-  infile = fopen(argv[1], "rb");
+  infile = fopen(input, "rb");
   if (!infile) {
     e = errno;
-    snprintf(buffer, sizeof(buffer), "/dev/%s", argv[1]);
+    snprintf(buffer, sizeof(buffer), "/dev/%s", input);
     infile = fopen(buffer, "rb");
     if (!infile) {
-      fprintf(stderr, i18n->could_not_open_ss, argv[1], i18n_error(e));
+      fprintf(stderr, i18n->could_not_open_ss, input, i18n_error(e));
       exit(1);
     }
   }
-  /* Drop root privileges if we had any. */
-  uid_t uid = getuid();
-  if (uid > 0 && setuid(uid) < 0) {
-    fprintf(stderr, "%s", i18n->could_not_restore_uid);
-    exit(1);
-  }
+  drop_privileges();
 
-  l = fread(buffer, 1, sizeof(buffer), infile);
+  l = fread(buffer, 1, sizeof(buffer) - 512, infile);
   if (l < 1024 || kum_6d6_header_read(start_header, buffer) || kum_6d6_header_read(end_header, buffer + 512)) {
     /* Try to skip first 512 bytes. */
     if (l >= 3 * 512 &&
       kum_6d6_header_read(start_header, buffer + 512) == 0 &&
       kum_6d6_header_read(end_header, buffer + 1024) == 0) {
       offset = 512;
+      /* Keep the writes to the output aligned. */
       l -= 512;
+      l += fread(buffer + offset + l, 1, 512, infile);
     } else {
       fprintf(stderr, "%s", i18n->malformed_6d6_header);
       exit(1);
     }
   }
+  position = offset + l;
 
-  outfile = fopen(argv[2], "wb");
+  /* Keep an earlier copy when resuming. */
+  outfile = resume_copy ? fopen(output, "r+b") : 0;
+  if (!outfile) outfile = fopen(output, resume_copy ? "w+b" : "wb");
   if (!outfile) {
-    fprintf(stderr, i18n->could_not_open_ss, argv[2], i18n_error(errno));
+    fprintf(stderr, i18n->could_not_open_ss, output, i18n_error(errno));
     exit(1);
   }
+  /* The output is written in whole chunks, stdio would only split them. */
+  setvbuf(outfile, 0, _IONBF, 0);
 
   end = (int64_t) end_header->address * 512;
+  preallocate(fileno(outfile), end);
 
   // Update the headers.
   if (append_comment) {
-    unescape(append_comment);
     if (append_string((char *) start_header->comment, append_comment, sizeof(start_header->comment)) < 0 || kum_6d6_header_write(start_header, buffer + offset) < 0) {
       fprintf(stderr, "%s", i18n->comment_too_long);
       exit(1);
     }
   }
 
-  m = end < l ? end : l;
-
-  l = fwrite(buffer + offset, 1, m, outfile);
-  if (m != l) io_error(1);
-
-  n = l;
-
-  _50ms = monotonic_time_ms(50);
   t0 = t1 = monotonic_time();
   if (progress == 2) {
-    fprintf(stdout, "{\"done\":0,\"total\":%"PRId64",\"elapsed\":0}\n", end);
+    fprintf(stdout, "{\"done\":0,\"total\":%"PRId64",\"elapsed\":0,\"throughput\":0}\n", end);
     fflush(stdout);
   }
+
+  n = 0;
+  if (resume_copy) {
+    n = resume(outfile, output, buffer + offset, end, &checksum, manifest_algorithms | CHECKSUM_CRC32C, &checkpoints);
+    if (n > 0 && progress == 1) fprintf(stderr, i18n->resuming_at_f, (double) n / 1000000);
+    if (fseeko(outfile, n, SEEK_SET)) io_error(3);
+  } else if (!(read_flags & BLOCKREADER_DIRECT) && !checksum && lseek(fileno(infile), 0, SEEK_CUR) >= 0) {
+    /* Let the kernel copy the recording unless direct I/O was requested or the
+     * data has to be hashed. Only the start header has to be replaced afterwards. */
+    n = copy_range(fileno(infile), fileno(outfile), offset, end, progress, t0, &t1);
+    n -= n % 512;
+    if (fseeko(outfile, n, SEEK_SET)) io_error(3);
+    if (n > 0 && fseeko(infile, offset + n, SEEK_SET)) io_error(2);
+    position = offset + n;
+    if (n > 0 && append_comment && pwrite(fileno(outfile), buffer + offset, 512, 0) != 512) io_error(1);
+  }
+
+  if (n == 0) {
+    m = end < l ? end : l;
+
+    l = fwrite(buffer + offset, 1, m, outfile);
+    if (m != l) io_error(1);
+    if (checksum) checksum_update(checksum, (uint8_t *) buffer + offset, m);
+    drop_written(fileno(outfile), &dropped, 0, m);
+
+    n = l;
+    throttle(n);
+  }
+
+  /* Read the rest of the recording. */
+  reader = blockreader_open(infile, position, offset + n, 512,
+    end > n ? (end - n) / 512 : 0, chunk_size / 512, queue_depth, read_flags);
+  if (!reader) io_error(2);
+
+  last_checkpoint = n;
+
   while (n < end) {
-    m = (end - n) > sizeof(buffer) ? sizeof(buffer) : end - n;
-    l = fread(buffer, 1, m, infile);
-    if (m != l) io_error(2);
-    l = fwrite(buffer, 1, m, outfile);
+    if (!(data = blockreader_get(reader))) io_error(2);
+    m = blockreader_length(reader);
+    /* Hash the chunk while it is written. */
+    throttle(m);
+    if (checksum) checksum_start(checksum, data, m);
+    l = fwrite(data, 1, m, outfile);
     if (m != l) io_error(3);
+    if (checksum) checksum_wait(checksum);
+    drop_written(fileno(outfile), &dropped, n, n + m);
     n += m;
-    if (progress == 1) {
-      fprintf(stderr, "%2$3d%% %1$6.1f MB        \r",
-        (double) n / 1000000,
-        (int) (100 * n / end));
-    } else if (progress == 2) {
-      t = monotonic_time();
-      if (t - t1 >= _50ms) {
-        fprintf(stdout,
-          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64"}\n",
-          n, end, (t - t0) * 50 / _50ms);
-        fflush(stdout);
-        t1 = t;
-      }
+    if (checkpoints && n - last_checkpoint >= CHECKPOINT_INTERVAL) {
+      if (fflush(outfile)) io_error(3);
+      fprintf(checkpoints, "%"PRId64" %08"PRIx32"\n", n, checksum_crc32c(checksum));
+      if (fflush(checkpoints)) io_error(4);
+      last_checkpoint = n;
     }
+    show_progress(progress, n, end, t0, &t1);
+  }
+
+  blockreader_destroy(reader);
+
+  if (fflush(outfile)) io_error(3);
+  if (checkpoints) {
+    /* An earlier copy might have been longer. The checkpoints are not needed
+     * anymore once the copy is complete. */
+    if (ftruncate(fileno(outfile), end)) io_error(3);
+    fclose(checkpoints);
+    snprintf(name, sizeof(name), "%s.checkpoint", output);
+    remove(name);
   }
+  drop_all(fileno(outfile));
+  if (manifest_algorithms) write_manifest(output, checksum, manifest_algorithms);
+  checksum_destroy(checksum);
 
+  /* Let the main process know when several copies are made at once. */
+  show_progress(0, end, end, t0, &t1);
   if (progress == 1) {
     fprintf(stderr, "%2$3d%% %1$6.1f MB        \n", (double) end / 1000000, 100);
   } else if (progress == 2) {
     t = monotonic_time();
     fprintf(stdout,
-          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64"}\n",
-          end, end, (t - t0) * 50 / _50ms);
+          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64"}\n",
+          end, end, (t - t0) * 50 / monotonic_time_ms(50), monotonic_throughput(end, t - t0));
     fflush(stdout);
   }
 
   return 0;
 }
+
+/* The disk which holds `filename`, so that copies from the same disk can be
+ * made one after another. Partitions are mapped to their disk.
+ * Returns -1 if the disk is not known. */
+static int device_of(const char *filename, dev_t *device)
+{
+  struct stat st;
+  char name[4096];
+#ifdef __linux__
+  unsigned a, b;
+  FILE *f;
+#endif
+
+  if (stat(filename, &st) < 0) {
+    snprintf(name, sizeof(name), "/dev/%s", filename);
+    if (stat(name, &st) < 0) return -1;
+  }
+  *device = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+#ifdef __linux__
+  snprintf(name, sizeof(name), "/sys/dev/block/%u:%u/partition", major(*device), minor(*device));
+  if (access(name, F_OK) == 0) {
+    snprintf(name, sizeof(name), "/sys/dev/block/%u:%u/../dev", major(*device), minor(*device));
+    if ((f = fopen(name, "r"))) {
+      if (fscanf(f, "%u:%u", &a, &b) == 2) *device = makedev(a, b);
+      fclose(f);
+    }
+  }
+#endif
+  return 0;
+}
+
+/* Show the progress of all copies together and of every single one. */
+static void show_all_progress(int progress, int count, const copy_status *copies, int64_t t0, int final)
+{
+  static const char *states[] = {"waiting", "running", "done", "failed"};
+  int64_t done = 0, total = 0, n, t;
+  int i, finished = 0;
+
+  for (i = 0; i < count; ++i) {
+    done += __atomic_load_n(&copies[i].done, __ATOMIC_RELAXED);
+    total += __atomic_load_n(&copies[i].total, __ATOMIC_RELAXED);
+    finished += copies[i].state >= COPY_DONE;
+  }
+  t = monotonic_time();
+
+  if (progress == 1) {
+    fprintf(stderr, "%3d%% %6.1f MB  %d/%d        %s",
+      total ? (int) (100 * done / total) : 0, (double) done / 1000000,
+      finished, count, final ? "\n" : "\r");
+  } else if (progress == 2) {
+    fprintf(stdout,
+      "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64",\"copies\":[",
+      done, total, (t - t0) * 50 / monotonic_time_ms(50), monotonic_throughput(done, t - t0));
+    for (i = 0; i < count; ++i) {
+      n = __atomic_load_n(&copies[i].done, __ATOMIC_RELAXED);
+      fprintf(stdout, "%s{\"done\":%"PRId64",\"total\":%"PRId64",\"throughput\":%"PRId64",\"state\":\"%s\"}",
+        i ? "," : "", n, __atomic_load_n(&copies[i].total, __ATOMIC_RELAXED),
+        copies[i].state == COPY_WAITING ? 0 :
+        monotonic_throughput(n, (copies[i].state == COPY_RUNNING ? t : copies[i].finished) - copies[i].started),
+        states[copies[i].state]);
+    }
+    fprintf(stdout, "]}\n");
+    fflush(stdout);
+  }
+}
+
+/* Copy several recordings at once. `files` holds `count` pairs of input and
+ * output. Every copy runs in its own process, but only one at a time reads
+ * from each disk. A slow or broken card does not hold up the others.
+ * Returns the number of failed copies. */
+static int copy_all(int count, char **files, int progress)
+{
+  copy_status *copies;
+  dev_t *devices;
+  pid_t *pids, pid;
+  int *known, i, j, busy, x, running = 0, failed = 0;
+  int64_t t0;
+  struct timespec delay = {0, 50000000};
+
+  /* The bandwidth clock is shared as well. */
+  copies = mmap(0, count * sizeof(copy_status) + sizeof(int64_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (copies == MAP_FAILED) io_error(5);
+  bandwidth_clock = (int64_t *) (copies + count);
+
+  devices = calloc(count, sizeof(dev_t));
+  pids = calloc(count, sizeof(pid_t));
+  known = calloc(count, sizeof(int));
+  if (!devices || !pids || !known) io_error(5);
+  for (i = 0; i < count; ++i) {
+    known[i] = device_of(files[2 * i], &devices[i]) == 0;
+  }
+
+  t0 = monotonic_time();
+  for (;;) {
+    /* Start the next copy on every idle disk. */
+    for (i = 0; i < count; ++i) {
+      if (copies[i].state != COPY_WAITING) continue;
+      busy = 0;
+      for (j = 0; j < count; ++j) {
+        if (copies[j].state == COPY_RUNNING && known[i] && known[j] && devices[i] == devices[j]) busy = 1;
+      }
+      if (busy) continue;
+
+      fflush(stdout);
+      fflush(stderr);
+      if ((pid = fork()) < 0) io_error(5);
+      if (pid == 0) {
+        status = &copies[i];
+        exit(copy(files[2 * i], files[2 * i + 1], 0));
+      }
+      pids[i] = pid;
+      copies[i].started = monotonic_time();
+      copies[i].state = COPY_RUNNING;
+      running += 1;
+    }
+    if (!running) break;
+
+    nanosleep(&delay, 0);
+    while ((pid = waitpid(-1, &x, WNOHANG)) > 0) {
+      for (i = 0; i < count && pids[i] != pid; ++i);
+      if (i == count) continue;
+      copies[i].finished = monotonic_time();
+      if (WIFEXITED(x) && WEXITSTATUS(x) == 0) {
+        copies[i].state = COPY_DONE;
+      } else {
+        copies[i].state = COPY_FAILED;
+        failed += 1;
+        if (progress == 1) fprintf(stderr, "\n");
+        fprintf(stderr, i18n->could_not_copy_ss, files[2 * i], files[2 * i + 1]);
+      }
+      running -= 1;
+    }
+    show_all_progress(progress, count, copies, t0, 0);
+  }
+  show_all_progress(progress, count, copies, t0, 1);
+
+  free(devices);
+  free(pids);
+  free(known);
+  munmap(copies, count * sizeof(copy_status) + sizeof(int64_t));
+
+  return failed;
+}
+
+int main(int argc, char **argv)
+{
+  int progress = 1, direct = 0, sha256 = 0, verify_only = 0;
+  char *queue_depth_string = 0, *chunk_size_string = 0, *bandwidth_string = 0;
+  int64_t bandwidth_time = 0;
+
+  i18n_set_lang(getenv("LANG"));
+
+  program = argv[0];
+  parse_options(&argc, &argv, OPTIONS(
+    FLAG('p', "progress", progress, 1),
+    FLAG('q', "no-progress", progress, 0),
+    FLAG(0, "json-progress", progress, 2),
+    FLAG(0, "direct", direct, 1),
+    PARAMETER(0, "queue-depth", queue_depth_string),
+    PARAMETER(0, "chunk-size", chunk_size_string),
+    PARAMETER(0, "append-comment", append_comment),
+    FLAG(0, "checksum", manifest_algorithms, CHECKSUM_CRC32C),
+    FLAG(0, "sha256", sha256, 1),
+    FLAG(0, "verify", verify_only, 1),
+    FLAG(0, "resume", resume_copy, 1),
+    FLAG(0, "drop-cache", drop_cache, 1),
+    PARAMETER(0, "bandwidth", bandwidth_string),
+    FLAG_CALLBACK('h', "help", help)
+  ));
+
+  if (verify_only ? argc != 2 : argc < 3 || argc % 2 == 0) help(0);
+
+  if (queue_depth_string && (blockreader_parse_number(queue_depth_string, &queue_depth) ||
+      queue_depth < 1 || queue_depth > BLOCKREADER_MAX_QUEUE_DEPTH)) {
+    fprintf(stderr, "%s", i18n->invalid_queue_depth);
+    exit(1);
+  }
+
+  if (chunk_size_string && (blockreader_parse_size(chunk_size_string, &chunk_size) ||
+      chunk_size < 512 || chunk_size % 512 || chunk_size > BLOCKREADER_MAX_CHUNK_SIZE)) {
+    fprintf(stderr, "%s", i18n->invalid_chunk_size);
+    exit(1);
+  }
+
+  if (bandwidth_string && (blockreader_parse_size(bandwidth_string, &bandwidth) || bandwidth < 1)) {
+    fprintf(stderr, "%s", i18n->invalid_bandwidth);
+    exit(1);
+  }
+
+  if (direct) read_flags = BLOCKREADER_DIRECT;
+
+  if (verify_only) {
+    /* The file and its manifest are opened with the rights of the user. */
+    drop_privileges();
+    return verify(argv[1], progress);
+  }
+
+  if (sha256) manifest_algorithms = CHECKSUM_CRC32C | CHECKSUM_SHA256;
+  if (append_comment) unescape(append_comment);
+
+  if (argc > 3) {
+    return copy_all((argc - 1) / 2, argv + 1, progress) ? 1 : 0;
+  }
+
+  bandwidth_clock = &bandwidth_time;
+  return copy(argv[1], argv[2], progress);
+}
+
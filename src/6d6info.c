@@ -7,7 +7,9 @@
 #include <math.h>
 #include <inttypes.h>
 #include "6d6.h"
+#include "decoder.h"
 #include "bcd.h"
+#include "blockreader.h"
 #include "options.h"
 #include "version.h"
 #include "tai.h"
@@ -24,6 +26,160 @@ static void help(const char *arg)
   exit(1);
 }
 
+static Time bcd_time(const uint8_t *bcd)
+{
+  Date date = {
+    .year = bcd_int(bcd[BCD_YEAR]) + 2000,
+    .month = bcd_int(bcd[BCD_MONTH]),
+    .day = bcd_int(bcd[BCD_DAY]),
+    .hour = bcd_int(bcd[BCD_HOUR]),
+    .min = bcd_int(bcd[BCD_MINUTE]),
+    .sec = bcd_int(bcd[BCD_SECOND]),
+    .usec = 0
+  };
+  return tai_time(date);
+}
+
+static void print_json_time(FILE *f, const char *key, Time t, int valid)
+{
+  Date d;
+  if (!valid) {
+    fprintf(f, ",\"%s\":null", key);
+    return;
+  }
+  d = tai_date(t, 0, 0);
+  fprintf(f, ",\"%s\":\"%d-%02d-%02dT%02d:%02d:%02d.%06dZ\"",
+    key, d.year, d.month, d.day, d.hour, d.min, d.sec, d.usec);
+}
+
+static void print_json_range(FILE *f, const char *key, int min, int max, double scale, int valid)
+{
+  if (!valid) {
+    fprintf(f, ",\"%s\":null", key);
+    return;
+  }
+  fprintf(f, ",\"%s\":{\"min\":%g,\"max\":%g}", key, min * scale, max * scale);
+}
+
+/* Walk through the frames of the recording and summarize the control frames
+ * in JSON. The sample frames are only counted. */
+static void scan(FILE *infile, int64_t base, kum_6d6_header *start_header, kum_6d6_header *end_header, FILE *aux)
+{
+  kum_6d6_decoder decoder[1];
+  const kum_6d6_event *event = &decoder->event;
+  Blockreader reader;
+  const uint8_t *data;
+  uint32_t i;
+  Time start_time, sync_time, skew_time, t = 0, first_time = 0;
+  double skew = 0;
+  int have_skew = 0;
+  int64_t time_frames = 0, lost_frames = 0, reboots = 0, last_sample_number = 0, size;
+  int end = 0, have_time = 0, have_vbat = 0, have_temperature = 0;
+  int vbat = 0, humidity = 0, temperature = 0;
+  int vbat_min = 0, vbat_max = 0, humidity_min = 0, humidity_max = 0;
+  int temperature_min = 0, temperature_max = 0;
+  Date d;
+
+  if (kum_6d6_decoder_init(decoder, start_header->channel_count)) {
+    fprintf(stderr, "%s", i18n->malformed_6d6_header);
+    exit(1);
+  }
+
+  /* Calculate times like 6d6mseed. */
+  sync_time = bcd_time(start_header->sync_time);
+  start_time = bcd_time(start_header->start_time);
+  start_time += 1000000 * (tai_utc_diff(start_time) - tai_utc_diff(sync_time));
+  if (end_header->sync_type == KUM_6D6_SKEW && bcd_valid((const char *) end_header->sync_time)) {
+    skew_time = bcd_time(end_header->sync_time);
+    skew = (double) (end_header->skew + 1000000 * (tai_utc_diff(skew_time) - tai_utc_diff(sync_time)) - start_header->skew) / (skew_time - sync_time);
+    have_skew = 1;
+  }
+
+  i = start_header->address > 2 ? start_header->address : 2;
+  size = end_header->address > i ? (int64_t) (end_header->address - i) * 512 : 0;
+  if (fseeko(infile, base + 2 * 512, SEEK_SET)) {
+    fprintf(stderr, "%s", i18n->io_error);
+    exit(1);
+  }
+  reader = blockreader_open(infile, base + 2 * 512, base + (int64_t) i * 512, 512,
+    size / 512, BLOCKREADER_CHUNK_SIZE / 512, 0, 0);
+  if (!reader) {
+    fprintf(stderr, "%s", i18n->io_error);
+    exit(1);
+  }
+  while (!end && i < end_header->address) {
+    if (!(data = blockreader_get(reader))) {
+      fprintf(stderr, "%s", i18n->io_error);
+      exit(1);
+    }
+    i += blockreader_length(reader) / 512;
+    kum_6d6_decoder_feed(decoder, data, blockreader_length(reader));
+    while (!end && kum_6d6_decoder_next_event(decoder) == KUM_6D6_DECODER_EVENT) {
+      switch (event->type) {
+      case KUM_6D6_TIME:
+        t = start_time + event->time;
+        if (have_skew) {
+          t += start_header->skew + round((t - sync_time) * skew);
+        }
+        if (!have_time) first_time = t;
+        have_time = 1;
+        time_frames += 1;
+        last_sample_number = event->sample_number;
+        break;
+      case KUM_6D6_VBAT:
+        vbat = event->vbat;
+        humidity = event->humidity;
+        if (!have_vbat || vbat < vbat_min) vbat_min = vbat;
+        if (!have_vbat || vbat > vbat_max) vbat_max = vbat;
+        if (!have_vbat || humidity < humidity_min) humidity_min = humidity;
+        if (!have_vbat || humidity > humidity_max) humidity_max = humidity;
+        have_vbat = 1;
+        break;
+      case KUM_6D6_TEMPERATURE:
+        temperature = event->temperature;
+        if (!have_temperature || temperature < temperature_min) temperature_min = temperature;
+        if (!have_temperature || temperature > temperature_max) temperature_max = temperature;
+        have_temperature = 1;
+        if (aux && have_time) {
+          d = tai_date(t, 0, 0);
+          fprintf(aux,
+            "%04d-%02d-%02d %02d:%02d:%02d UTC,%.2f,%d,%.2f\n",
+            d.year, d.month, d.day, d.hour, d.min, d.sec,
+            temperature * 0.01, humidity, vbat * 0.01);
+        }
+        break;
+      case KUM_6D6_LOST:
+        lost_frames += 1;
+        break;
+      case KUM_6D6_REBOOT:
+        reboots += 1;
+        break;
+      case KUM_6D6_END:
+        end = 1;
+        break;
+      default: break;
+      }
+    }
+  }
+  blockreader_destroy(reader);
+
+  fprintf(stdout, "{\"size\":%"PRId64, size);
+  fprintf(stdout, ",\"sample_frames\":%"PRId64, decoder->sample_number);
+  fprintf(stdout, ",\"time_frames\":%"PRId64, time_frames);
+  print_json_time(stdout, "first_time", first_time, have_time);
+  print_json_time(stdout, "last_time", t, have_time);
+  /* The samples after the last time frame run on at the sample rate. */
+  print_json_time(stdout, "end_time", t + (int64_t) round((decoder->sample_number - last_sample_number) * 1000000.0 / start_header->sample_rate),
+    have_time && start_header->sample_rate);
+  fprintf(stdout, ",\"lost_frames\":%"PRId64, lost_frames);
+  fprintf(stdout, ",\"reboots\":%"PRId64, reboots);
+  fprintf(stdout, ",\"end_frame\":%s", end ? "true" : "false");
+  print_json_range(stdout, "temperature", temperature_min, temperature_max, 0.01, have_temperature);
+  print_json_range(stdout, "humidity", humidity_min, humidity_max, 1, have_vbat);
+  print_json_range(stdout, "battery_voltage", vbat_min, vbat_max, 0.01, have_vbat);
+  fprintf(stdout, "}\n");
+}
+
 int main(int argc, char **argv)
 {
   FILE *infile;
@@ -32,6 +188,10 @@ int main(int argc, char **argv)
   kum_6d6_header start_header[1], end_header[1];
   int e;
   int json = 0;
+  int do_scan = 0;
+  int64_t base = 0;
+  FILE *aux = 0;
+  char *aux_path = 0;
 
   i18n_set_lang(getenv("LANG"));
 
@@ -43,7 +203,9 @@ int main(int argc, char **argv)
   program = argv[0];
   parse_options(&argc, &argv, OPTIONS(
     FLAG_CALLBACK('h', "help", help),
-    FLAG(0, "json", json, 1)
+    FLAG(0, "json", json, 1),
+    FLAG(0, "scan", do_scan, 1),
+    PARAMETER('x', "auxfile", aux_path)
   ));
 
   if (argc != 2) help(0);
@@ -72,12 +234,30 @@ int main(int argc, char **argv)
     if (l >= 3 * 512 &&
       kum_6d6_header_read(start_header, buffer + 512) == 0 &&
       kum_6d6_header_read(end_header, buffer + 1024) == 0) {
+      base = 512;
     } else {
       fprintf(stderr, "%s", i18n->malformed_6d6_header);
       exit(1);
     }
   }
 
+  if (do_scan) {
+    if (aux_path) {
+      aux = fopen(aux_path, "wb");
+      if (!aux) {
+        fprintf(stderr, i18n->could_not_open_ss, aux_path, i18n_error(errno));
+        exit(1);
+      }
+      fprintf(aux, "Time,Temperature [°C],Humidity [%%],Battery Voltage [V]\n");
+    }
+    scan(infile, base, start_header, end_header, aux);
+    if (aux && fclose(aux)) {
+      fprintf(stderr, "%s", i18n->io_error);
+      exit(1);
+    }
+    return 0;
+  }
+
   /* Show all the info. */
   if (json) {
     kum_6d6_show_info_json(stdout, start_header, end_header);
@@ -5,11 +5,16 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
-#include <assert.h>
 #include <stdarg.h>
 #include <inttypes.h>
 #include "6d6.h"
+#include "decoder.h"
+#include "find_timestamp.h"
+#include "index.h"
+#include "parallel.h"
+#include "pool.h"
 #include "bcd.h"
+#include "blockreader.h"
 #include "number.h"
 #include "options.h"
 #include "version.h"
@@ -65,15 +70,6 @@ static void read_block(uint8_t *block, FILE *f)
   }
 }
 
-static int try_read_block(uint8_t *block, FILE *f)
-{
-  if (fread(block, 512, 1, f) != 1) {
-    log_entry(stderr, i18n->io_error);
-    return 1;
-  }
-  return 0;
-}
-
 static Time bcd_time(const uint8_t *bcd)
 {
   Date date = {
@@ -122,6 +118,71 @@ static void split_channel_names(char **channel_names)
   }
 }
 
+/* The channels and the clock, shared by the threads converting the
+ * channels. */
+static WMSeed *channels[KUM_6D6_MAX_CHANNEL_COUNT];
+static int n_channels;
+static int have_time[KUM_6D6_MAX_CHANNEL_COUNT];
+static Time start_time, sync_time;
+static int64_t start_skew;
+static double skew = 1;
+static int have_skew = 0;
+
+/* The time of a time frame, corrected for the skew of the clock. */
+static Time frame_time(const kum_6d6_event *event)
+{
+  Time t = start_time + event->time;
+  if (have_skew) {
+    t += start_skew + round((t - sync_time) * skew);
+  }
+  return t;
+}
+
+typedef struct {
+  /* Converts the channels first, first + step, ... */
+  int first, step;
+  const kum_6d6_result *results;
+  int64_t count;
+} convert_job;
+
+/* Pass the samples and time frames of the results to the channels of the
+ * job, up to the end frame. */
+static void *convert_channels(void *x)
+{
+  convert_job *job = x;
+  const kum_6d6_result *r;
+  int64_t k;
+  int c;
+
+  for (k = 0; k < job->count; ++k) {
+    r = &job->results[k];
+    if (r->type == KUM_6D6_DECODER_SAMPLES) {
+      for (c = job->first; c < n_channels; c += job->step) {
+        if (have_time[c]) wmseed_samples(channels[c], r->samples[c], r->count);
+      }
+    } else if (r->event->type == KUM_6D6_TIME) {
+      for (c = job->first; c < n_channels; c += job->step) {
+        have_time[c] = 1;
+        wmseed_time(channels[c], frame_time(r->event));
+      }
+    } else if (r->event->type == KUM_6D6_END) {
+      break;
+    }
+  }
+  return 0;
+}
+
+/* Check if every channel has passed the end time. */
+static int all_finished(void)
+{
+  int c;
+
+  for (c = 0; c < n_channels; ++c) {
+    if (!wmseed_finished(channels[c])) return 0;
+  }
+  return 1;
+}
+
 static int parse_time(const char *s, Time *t)
 {
   Date d;
@@ -138,23 +199,33 @@ int main(int argc, char **argv)
 {
   kum_6d6_header h_start, h_end;
   FILE *input = 0;
-  WMSeed *channels[KUM_6D6_MAX_CHANNEL_COUNT];
+  Blockreader reader;
   char *channel_names[KUM_6D6_MAX_CHANNEL_COUNT + 1] = {0};
-  int n_channels;
   uint8_t block[512];
+  const uint8_t *data;
   char str[512];
   const char *filename = "-";
-  uint32_t i, j;
+  int64_t base = 0, n;
+  uint32_t i;
   int c, e;
-  Time start_time, sync_time, skew_time = 0, t;
+  Time skew_time = 0, t = 0;
   Date d;
-  double skew = 1;
-  int have_skew = 0;
   int ignore_skew = 0;
-  /* Block parser. */
-  int pos, remaining = 0, have_time = 0;
-  int32_t frame[KUM_6D6_MAX_CHANNEL_COUNT];
+  kum_6d6_parallel *decoder;
+  const kum_6d6_result *results, *r;
+  int64_t count, k;
+  convert_job jobs[KUM_6D6_MAX_CHANNEL_COUNT];
+  kum_6d6_pool *pool;
+  int threads = 1, n_jobs, end = 0;
+  char *threads_string = 0;
+  int have_any_time = 0;
   int64_t sample_number = 0;
+  kum_6d6_index index;
+  const kum_6d6_index_entry *entry;
+  char *index_path, *index_file = 0;
+  int build_index = 0;
+  kum_6d6_timestamp found;
+  int64_t skip = 0, seek_time, length;
 
   FILE *aux = 0;
   char *aux_path = 0;
@@ -172,16 +243,28 @@ int main(int argc, char **argv)
 
   char *start_time_string = 0;
   char *end_time_string = 0;
+  char *queue_depth_string = 0, *chunk_size_string = 0;
+  int64_t queue_depth = 0, chunk_size = BLOCKREADER_CHUNK_SIZE;
   Time start_time_limit = INT64_MIN;
   Time end_time_limit = INT64_MAX;
 
   int progress = 1;
+  int direct = 0;
 
   int64_t t0, t1, t2, _50ms, total;
 
   // Flag if the data should be resampled.
   int resample = 0;
 
+  char *encoding_string = 0;
+  int encoding = MINISEED_INT32;
+
+  char *record_length_string = 0;
+  int record_length = MINISEED_RECORD_SIZE;
+
+  char *write_buffer_string = 0;
+  int64_t write_buffer = WMSEED_BUFFER_SIZE;
+
   i18n_set_lang(getenv("LANG"));
 
   int outdated = tai_leapsecs_need_update(tai_now());
@@ -194,6 +277,10 @@ int main(int argc, char **argv)
     FLAG('p', "progress", progress, 1),
     FLAG('q', "no-progress", progress, 0),
     FLAG(0, "json-progress", progress, 2),
+    FLAG(0, "direct", direct, 1),
+    PARAMETER(0, "queue-depth", queue_depth_string),
+    PARAMETER(0, "chunk-size", chunk_size_string),
+    PARAMETER(0, "threads", threads_string),
     FLAG_CALLBACK('h', "help", help),
     PARAMETER(0, "station", station),
     PARAMETER(0, "location", location),
@@ -204,11 +291,16 @@ int main(int argc, char **argv)
     FLAG(0, "no-cut", no_cut, 1),
     PARAMETER(0, "start-time", start_time_string),
     PARAMETER(0, "end-time", end_time_string),
+    FLAG(0, "index", build_index, 1),
+    PARAMETER(0, "index-file", index_file),
     PARAMETER('l', "logfile", logfile),
     PARAMETER('x', "auxfile", aux_path),
     PARAMETER(0, "debug", debug_path),
     FLAG(0, "ignore-skew", ignore_skew, 1),
-    FLAG(0, "resample", resample, 1)
+    FLAG(0, "resample", resample, 1),
+    PARAMETER(0, "encoding", encoding_string),
+    PARAMETER(0, "record-length", record_length_string),
+    PARAMETER(0, "write-buffer", write_buffer_string)
   ));
 
   if (channel_names[0]) split_channel_names(channel_names);
@@ -229,6 +321,35 @@ int main(int argc, char **argv)
     cut = 0;
   }
 
+  if (encoding_string) {
+    if (!strcmp(encoding_string, "int32")) {
+      encoding = MINISEED_INT32;
+    } else if (!strcmp(encoding_string, "steim1")) {
+      encoding = MINISEED_STEIM1;
+    } else if (!strcmp(encoding_string, "steim2")) {
+      encoding = MINISEED_STEIM2;
+    } else {
+      fatal(i18n->invalid_encoding);
+    }
+  }
+
+  if (record_length_string) {
+    int n = 0;
+    while (*record_length_string) {
+      if (*record_length_string < '0' || *record_length_string > '9') fatal(i18n->invalid_record_length);
+      n = n * 10 + *record_length_string - '0';
+      if (n > MINISEED_MAX_RECORD_SIZE) fatal(i18n->invalid_record_length);
+      ++record_length_string;
+    }
+    if (n < MINISEED_MIN_RECORD_SIZE || (n & (n - 1))) fatal(i18n->invalid_record_length);
+    record_length = n;
+  }
+
+  if (write_buffer_string && (blockreader_parse_size(write_buffer_string, &write_buffer) ||
+      write_buffer < MINISEED_MAX_RECORD_SIZE || write_buffer % MINISEED_MAX_RECORD_SIZE || write_buffer > BLOCKREADER_MAX_CHUNK_SIZE)) {
+    fatal(i18n->invalid_write_buffer);
+  }
+
   if (start_time_string) {
     if (parse_time(start_time_string, &start_time_limit)) {
       fatal(i18n->invalid_start_time);
@@ -241,6 +362,27 @@ int main(int argc, char **argv)
     }
   }
 
+  if (queue_depth_string && (blockreader_parse_number(queue_depth_string, &queue_depth) ||
+      queue_depth < 1 || queue_depth > BLOCKREADER_MAX_QUEUE_DEPTH)) {
+    fatal(i18n->invalid_queue_depth);
+  }
+
+  if (chunk_size_string && (blockreader_parse_size(chunk_size_string, &chunk_size) ||
+      chunk_size < 512 || chunk_size % 512 || chunk_size > BLOCKREADER_MAX_CHUNK_SIZE)) {
+    fatal(i18n->invalid_chunk_size);
+  }
+
+  if (threads_string) {
+    threads = 0;
+    while (*threads_string) {
+      if (*threads_string < '0' || *threads_string > '9') fatal(i18n->invalid_threads);
+      threads = threads * 10 + *threads_string - '0';
+      if (threads > 256) fatal(i18n->invalid_threads);
+      ++threads_string;
+    }
+    if (threads < 1) fatal(i18n->invalid_threads);
+  }
+
   if (!template) {
     if (cut >= 86400) {
       template = "out/%S/%y-%m-%d-%C.mseed";
@@ -327,6 +469,7 @@ int main(int argc, char **argv)
       log_entry(stderr, "%s", i18n->malformed_6d6_header);
       exit(1);
     }
+    base = 512;
   }
   read_block(block, input);
   if (kum_6d6_header_read(&h_end, block) == -1) {
@@ -345,9 +488,28 @@ int main(int argc, char **argv)
     skew = (double) (h_end.skew - h_start.skew) / (skew_time - sync_time);
     have_skew = 1;
   }
+  start_skew = h_start.skew;
   /* Create Channels. */
   n_channels = h_start.channel_count;
-  assert(0 <= n_channels && n_channels <= KUM_6D6_MAX_CHANNEL_COUNT);
+  if (n_channels < 1 || n_channels > KUM_6D6_MAX_CHANNEL_COUNT) {
+    log_entry(stderr, "%s", i18n->malformed_6d6_header);
+    exit(1);
+  }
+  if (!(decoder = kum_6d6_parallel_new(n_channels, threads))) {
+    log_entry(stderr, "%s", i18n->out_of_memory);
+    exit(1);
+  }
+  /* Every thread converts some of the channels. */
+  n_jobs = threads < n_channels ? threads : n_channels;
+  for (c = 0; c < n_jobs; ++c) {
+    jobs[c].first = c;
+    jobs[c].step = n_jobs;
+  }
+  /* The last job runs on this thread. */
+  if (!(pool = kum_6d6_pool_new(n_jobs - 1, convert_channels, jobs, sizeof(*jobs)))) {
+    log_entry(stderr, "%s", i18n->out_of_memory);
+    exit(1);
+  }
   /* Check if there are exactly as many names as there are channels. */
   if (channel_names[0]) {
     for (c = 0; c < n_channels; ++c) {
@@ -367,6 +529,9 @@ int main(int argc, char **argv)
       resample);
     wmseed_start_time(channels[c], start_time_limit);
     wmseed_end_time(channels[c], end_time_limit);
+    wmseed_encoding(channels[c], encoding);
+    wmseed_record_length(channels[c], record_length);
+    wmseed_buffer_size(channels[c], write_buffer);
   }
 
   if (channel_names[0]) {
@@ -397,102 +562,142 @@ int main(int argc, char **argv)
   t0 = t1 = monotonic_time();
   total = h_end.address * 512;
   if (progress == 2) {
-    fprintf(stdout, "{\"done\":0,\"total\":%"PRId64",\"elapsed\":0}\n", total);
+    fprintf(stdout, "{\"done\":0,\"total\":%"PRId64",\"elapsed\":0,\"throughput\":0}\n", total);
     fflush(stdout);
   }
 
-  i = 2;
-  /* Skip to start of data.
-   * Can not fseek, because stream might not be seekable. */
-  while (i < h_start.address) {
-    read_block(block, input);
-    ++i;
+  i = h_start.address > 2 ? h_start.address : 2;
+  /* Build the index if asked for. Seek to the start time with the index, or
+   * by bisecting the data if there is no index. */
+  if ((build_index || start_time_limit != INT64_MIN) && fseeko(input, 0, SEEK_CUR) == 0) {
+    length = h_end.address > i ? (int64_t) (h_end.address - i) * 512 : 0;
+    kum_6d6_index_init(&index, &h_start, &h_end);
+    index_path = index_file ? strdup(index_file) : kum_6d6_index_path(filename);
+    if (build_index && !index_path) fatal(i18n->index_needs_path);
+    if (index_path && kum_6d6_index_read(&index, index_path) && build_index) {
+      if (kum_6d6_index_build(&index, input, base + (int64_t) i * 512, length)) {
+        log_entry(stderr, "%s", i18n->io_error);
+        exit(1);
+      }
+      if (kum_6d6_index_write(&index, index_path)) {
+        log_entry(stderr, i18n->could_not_create_file_ss, index_path, i18n_error(errno));
+      } else {
+        log_entry(stderr, i18n->created_file_s, index_path);
+      }
+    }
+    if (start_time_limit != INT64_MIN) {
+      seek_time = start_time_limit - start_time - KUM_6D6_SEEK_MARGIN;
+      if (index.count) {
+        if ((entry = kum_6d6_index_find(&index, seek_time))) {
+          i += entry->offset / 512;
+          skip = entry->offset % 512;
+          sample_number = entry->sample_number;
+        }
+      } else if (kum_6d6_bisect(input, base + (int64_t) i * 512, length, seek_time, &found) == 0) {
+        i += found.offset / 512;
+        skip = found.offset % 512;
+        /* Bisecting does not count the samples before the time frame. There
+         * is one every 1/sample_rate seconds, so this is the number the index
+         * would give unless frames were lost before. */
+        sample_number = (found.time * h_start.sample_rate + 500000) / 1000000;
+      }
+    }
+    if (fseeko(input, base + 2 * 512, SEEK_SET)) {
+      log_entry(stderr, "%s", i18n->io_error);
+      exit(1);
+    }
+    kum_6d6_index_free(&index);
+    free(index_path);
+  } else if (build_index) {
+    fatal(i18n->index_needs_seek);
+  }
+  reader = blockreader_open(input, base + 2 * 512, base + (int64_t) i * 512, 512,
+    h_end.address > i ? h_end.address - i : 0, chunk_size / 512, queue_depth,
+    direct ? BLOCKREADER_DIRECT : 0);
+  if (!reader) {
+    log_entry(stderr, "%s", i18n->io_error);
+    exit(1);
   }
   /* Read data. */
   while (i < h_end.address) {
-    if (try_read_block(block, input)) {
+    if (!(data = blockreader_get(reader))) {
+      log_entry(stderr, "%s", i18n->io_error);
       goto done;
     }
-    ++i;
+    n = blockreader_length(reader);
+    i += n / 512;
+    data += skip;
+    n -= skip;
+    skip = 0;
     /* Process block. */
-    for (j = 0; j < 512; j += 4) {
-      if (!remaining) {
-        frame[0] = ld_i32_be(block + j);
-        remaining = (frame[0] & 1) ? 3 : (n_channels - 1);
-        pos = 1;
-      } else {
-        frame[pos++] = ld_i32_be(block + j);
-        --remaining;
+    if (kum_6d6_parallel_feed(decoder, data, n)) {
+      log_entry(stderr, "%s", i18n->out_of_memory);
+      exit(1);
+    }
+    while (!end && (count = kum_6d6_parallel_next(decoder, &results)) > 0) {
+      for (c = 0; c < n_jobs; ++c) {
+        jobs[c].results = results;
+        jobs[c].count = count;
       }
-      if (!remaining) {
-        if (frame[0] & 1) {
-          /* Control Frame */
-          switch (frame[0]) {
-          case 1: /* Time */
-            have_time = 1;
-            for (c = 0; c < n_channels; ++c) {
-              t = start_time + (frame[1] * (int64_t) 1000000 + frame[2]);
-              if (have_skew) {
-                t += h_start.skew + round((t - sync_time) * skew);
-              }
-              wmseed_time(channels[c], t);
-            }
-            if (debug) {
-              fprintf(debug, "%lld.%06lld,%lld\n", (long long) t / 1000000, (long long) t % 1000000, (long long) sample_number);
-            }
-            break;
-          case 3: /* VBat/Humidity */
-            vbat = frame[1] >> 16;
-            humidity = frame[1] & 0xffff;
-            break;
-          case 5: /* Temperature */
-            temperature = frame[1] >> 16;
-            if (aux) {
-              d = tai_date(t, 0, 0);
-              fprintf(aux,
-                "%04d-%02d-%02d %02d:%02d:%02d UTC,%.2f,%d,%.2f\n",
-                d.year, d.month, d.day, d.hour, d.min, d.sec,
-                temperature * 0.01, humidity, vbat * 0.01);
-              fflush(aux);
-            }
-            break;
-          case 7: /* Lost Frames */
-            break;
-          case 9: /* Check Frame */
-            break;
-          case 11: /* Reboot */
-            break;
-          case 13: /* End Frame */
-            goto done;
-          case 15: /* Frame Number */
-            break;
-          default: break;
+      kum_6d6_pool_start(pool, n_jobs - 1);
+      /* Write the debug and aux files while the channels are converted. */
+      for (k = 0; k < count && !end; ++k) {
+        r = &results[k];
+        if (r->type == KUM_6D6_DECODER_SAMPLES) {
+          if (have_any_time) sample_number += r->count;
+          continue;
+        }
+        switch (r->event->type) {
+        case KUM_6D6_TIME:
+          have_any_time = 1;
+          t = frame_time(r->event);
+          if (debug) {
+            fprintf(debug, "%lld.%06lld,%lld\n", (long long) t / 1000000, (long long) t % 1000000, (long long) sample_number);
           }
-        } else {
-          if (have_time) {
-            for (c = 0; c < n_channels; ++c) {
-              wmseed_sample(channels[c], frame[c]);
-            }
-            sample_number += 1;
+          break;
+        case KUM_6D6_VBAT:
+          vbat = r->event->vbat;
+          humidity = r->event->humidity;
+          break;
+        case KUM_6D6_TEMPERATURE:
+          temperature = r->event->temperature;
+          if (aux) {
+            d = tai_date(t, 0, 0);
+            fprintf(aux,
+              "%04d-%02d-%02d %02d:%02d:%02d UTC,%.2f,%d,%.2f\n",
+              d.year, d.month, d.day, d.hour, d.min, d.sec,
+              temperature * 0.01, humidity, vbat * 0.01);
+            fflush(aux);
           }
+          break;
+        case KUM_6D6_END:
+          end = 1;
+          break;
+        default: break;
         }
       }
+      convert_channels(&jobs[n_jobs - 1]);
+      kum_6d6_pool_wait(pool);
     }
-    if (progress == 1 && i % 1024 == 0) {
+    if (end || all_finished()) goto done;
+    if (progress == 1) {
       fprintf(stderr, "%3d%% %6.1fMB     \r", (int) (i * 100 / h_end.address), (double) i * 512 / 1000000l);
       fflush(stderr);
     } else if (progress == 2) {
       t2 = monotonic_time();
       if (t2 - t1 >= _50ms) {
         fprintf(stdout,
-          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64"}\n",
-          (int64_t) i * 512, total, (t2 - t0) * 50 / _50ms);
+          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64"}\n",
+          (int64_t) i * 512, total, (t2 - t0) * 50 / _50ms, monotonic_throughput((int64_t) i * 512, t2 - t0));
         fflush(stdout);
         t1 = t2;
       }
     }
   }
 done:
+  blockreader_destroy(reader);
+  kum_6d6_parallel_destroy(decoder);
+  kum_6d6_pool_destroy(pool);
   for (c = 0; c < n_channels; ++c) {
     wmseed_destroy(channels[c]);
   }
@@ -502,8 +707,8 @@ done:
   } else if (progress == 2) {
     t2 = monotonic_time();
     fprintf(stdout,
-          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64"}\n",
-          total, total, (t2 - t0) * 50 / _50ms);
+          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64"}\n",
+          total, total, (t2 - t0) * 50 / _50ms, monotonic_throughput(total, t2 - t0));
     fflush(stdout);
   }
 
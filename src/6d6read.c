@@ -7,7 +7,11 @@
 #include <string.h>
 #include <inttypes.h>
 #include "6d6.h"
+#include "decoder.h"
+#include "find_timestamp.h"
+#include "index.h"
 #include "bcd.h"
+#include "blockreader.h"
 #include "number.h"
 #include "options.h"
 #include "s2x.h"
@@ -115,28 +119,40 @@ int main(int argc, char **argv)
   s2x_header h;
   kum_6d6_header h_start, h_end;
   FILE *input = stdin, *output = stdout;
+  Blockreader reader;
   SampleTracker st[1];
   s2x_channel *channels[KUM_6D6_MAX_CHANNEL_COUNT];
   uint8_t block[512], x[16];
+  const uint8_t *data;
   char str[512];
-  uint32_t i, j;
-  int c, e;
+  const char *filename = 0;
+  int64_t base = 0, n;
+  uint32_t i;
+  int c, e, k;
   int64_t start_time, sync_time, skew_time = 0;
   int64_t t, last_t = -1;
   int32_t skew = 0;
-  /* Block parser. */
-  int pos, remaining = 0, have_time = 0;
-  int32_t frame[KUM_6D6_MAX_CHANNEL_COUNT];
+  kum_6d6_decoder decoder[1];
+  int have_time = 0;
+  kum_6d6_index index;
+  const kum_6d6_index_entry *entry;
+  char *index_path, *index_file = 0;
+  int build_index = 0;
+  kum_6d6_timestamp found;
+  int64_t skip = 0, seek_time, length;
 
   Time start_time_tai, time_tai;
   Time start_time_limit = INT64_MIN;
   Time end_time_limit = INT64_MAX;
   char *start_time_string = 0;
   char *end_time_string = 0;
+  char *queue_depth_string = 0, *chunk_size_string = 0;
+  int64_t queue_depth = 0, chunk_size = BLOCKREADER_CHUNK_SIZE;
 
   i18n_set_lang(getenv("LANG"));
 
   int progress = 1;
+  int direct = 0;
 
   int64_t t0, t1, t2, _50ms, total;
 
@@ -145,8 +161,13 @@ int main(int argc, char **argv)
     FLAG('p', "progress", progress, 1),
     FLAG('q', "no-progress", progress, 0),
     FLAG(0, "json-progress", progress, 2),
+    FLAG(0, "direct", direct, 1),
+    PARAMETER(0, "queue-depth", queue_depth_string),
+    PARAMETER(0, "chunk-size", chunk_size_string),
     PARAMETER(0, "start-time", start_time_string),
     PARAMETER(0, "end-time", end_time_string),
+    FLAG(0, "index", build_index, 1),
+    PARAMETER(0, "index-file", index_file),
     FLAG_CALLBACK('h', "help", help)
   ));
 
@@ -164,14 +185,28 @@ int main(int argc, char **argv)
     }
   }
 
+  if (queue_depth_string && (blockreader_parse_number(queue_depth_string, &queue_depth) ||
+      queue_depth < 1 || queue_depth > BLOCKREADER_MAX_QUEUE_DEPTH)) {
+    fprintf(stderr, "%s", i18n->invalid_queue_depth);
+    exit(1);
+  }
+
+  if (chunk_size_string && (blockreader_parse_size(chunk_size_string, &chunk_size) ||
+      chunk_size < 512 || chunk_size % 512 || chunk_size > BLOCKREADER_MAX_CHUNK_SIZE)) {
+    fprintf(stderr, "%s", i18n->invalid_chunk_size);
+    exit(1);
+  }
+
   /* Set input/output files. */
   if (isatty(0)) {
     if (argc == 2) {
-      input = fopen(argv[1], "rb");
+      filename = argv[1];
+      input = fopen(filename, "rb");
       if (!input) {
         e = errno;
         snprintf(str, sizeof(str), "/dev/%s", argv[1]);
-        input = fopen(str, "rb");
+        filename = str;
+        input = fopen(filename, "rb");
         if (!input) {
           fprintf(stderr, i18n->could_not_open_ss, argv[1], i18n_error(e));
           exit(1);
@@ -200,6 +235,7 @@ int main(int argc, char **argv)
       fprintf(stderr, "%s", i18n->malformed_6d6_header);
       exit(1);
     }
+    base = 512;
   }
   read_block(block, input);
   if (kum_6d6_header_read(&h_end, block) == -1) {
@@ -207,6 +243,11 @@ int main(int argc, char **argv)
     exit(1);
   }
 
+  if (kum_6d6_decoder_init(decoder, h_start.channel_count)) {
+    fprintf(stderr, "%s", i18n->malformed_6d6_header);
+    exit(1);
+  }
+
   /* Init sample tracker. */
   sample_tracker_init(st, h_start.sample_rate);
 
@@ -252,101 +293,134 @@ int main(int argc, char **argv)
   t0 = t1 = monotonic_time();
   total = h_end.address * 512;
   if (progress == 2) {
-    fprintf(stderr, "{\"done\":0,\"total\":%"PRId64",\"elapsed\":0}\n", total);
+    fprintf(stderr, "{\"done\":0,\"total\":%"PRId64",\"elapsed\":0,\"throughput\":0}\n", total);
     fflush(stderr);
   }
 
-  i = 2;
-  /* Skip to start of data.
-   * Can not fseek, because stream might not be seekable. */
-  while (i < h_start.address) {
-    read_block(block, input);
-    ++i;
+  i = h_start.address > 2 ? h_start.address : 2;
+  /* Build the index if asked for. Seek to the start time with the index, or
+   * by bisecting the data if there is no index. */
+  if ((build_index || start_time_limit != INT64_MIN) && fseeko(input, 0, SEEK_CUR) == 0) {
+    length = h_end.address > i ? (int64_t) (h_end.address - i) * 512 : 0;
+    kum_6d6_index_init(&index, &h_start, &h_end);
+    index_path = index_file ? strdup(index_file) : filename ? kum_6d6_index_path(filename) : 0;
+    if (build_index && !index_path) {
+      fprintf(stderr, "%s", i18n->index_needs_path);
+      exit(1);
+    }
+    if (index_path && kum_6d6_index_read(&index, index_path) && build_index) {
+      if (kum_6d6_index_build(&index, input, base + (int64_t) i * 512, length)) {
+        fprintf(stderr, "%s", i18n->io_error);
+        exit(1);
+      }
+      if (kum_6d6_index_write(&index, index_path)) {
+        fprintf(stderr, i18n->could_not_create_file_ss, index_path, i18n_error(errno));
+      } else {
+        fprintf(stderr, i18n->created_file_s, index_path);
+      }
+    }
+    if (start_time_limit != INT64_MIN) {
+      seek_time = start_time_limit - start_time_tai - KUM_6D6_SEEK_MARGIN;
+      if (index.count) {
+        if ((entry = kum_6d6_index_find(&index, seek_time))) {
+          i += entry->offset / 512;
+          skip = entry->offset % 512;
+        }
+      } else if (kum_6d6_bisect(input, base + (int64_t) i * 512, length, seek_time, &found) == 0) {
+        i += found.offset / 512;
+        skip = found.offset % 512;
+      }
+    }
+    if (fseeko(input, base + 2 * 512, SEEK_SET)) {
+      fprintf(stderr, "%s", i18n->io_error);
+      exit(1);
+    }
+    kum_6d6_index_free(&index);
+    free(index_path);
+  } else if (build_index) {
+    fprintf(stderr, "%s", i18n->index_needs_seek);
+    exit(1);
+  }
+  reader = blockreader_open(input, base + 2 * 512, base + (int64_t) i * 512, 512,
+    h_end.address > i ? h_end.address - i : 0, chunk_size / 512, queue_depth,
+    direct ? BLOCKREADER_DIRECT : 0);
+  if (!reader) {
+    fprintf(stderr, "%s", i18n->io_error);
+    exit(1);
   }
   /* Read data. */
   while (i < h_end.address) {
-    read_block(block, input);
-    ++i;
+    if (!(data = blockreader_get(reader))) {
+      fprintf(stderr, "%s", i18n->io_error);
+      exit(1);
+    }
+    n = blockreader_length(reader);
+    i += n / 512;
+    data += skip;
+    n -= skip;
+    skip = 0;
     /* Process block. */
-    for (j = 0; j < 512; j += 4) {
-      if (!remaining) {
-        frame[0] = ld_i32_be(block + j);
-        remaining = (frame[0] & 1) ? 3 : (h_start.channel_count - 1);
-        pos = 1;
-      } else {
-        frame[pos++] = ld_i32_be(block + j);
-        --remaining;
+    kum_6d6_decoder_feed(decoder, data, n);
+    while ((e = kum_6d6_decoder_next(decoder)) != KUM_6D6_DECODER_NEED_DATA) {
+      if (e == KUM_6D6_DECODER_EVENT) {
+        /* Control Frame */
+        switch (decoder->event.type) {
+        case KUM_6D6_TIME:
+          /* Put the time into the sample tracker. */
+          sample_tracker_time(st, decoder->event.time);
+          if (!have_time) have_time = 1;
+          break;
+        case KUM_6D6_END:
+          goto done;
+        default: break;
+        }
+        continue;
       }
-      if (!remaining) {
-        if (frame[0] & 1) {
-          /* Control Frame */
-          switch (frame[0]) {
-          case 1: /* Time */
-            /* Put the time into the sample tracker. */
-            sample_tracker_time(st, (int64_t) frame[1] * 1000000 + frame[2]);
-            if (!have_time) have_time = 1;
-            break;
-          case 3: /* VBat/Humidity */
-            break;
-          case 5: /* Temperature */
-            break;
-          case 7: /* Lost Frames */
-            break;
-          case 9: /* Check Frame */
-            break;
-          case 11: /* Reboot */
-            break;
-          case 13: /* End Frame */
-            goto done;
-          case 15: /* Frame Number */
-            break;
-          default: break;
-          }
-        } else {
-          if (have_time) {
-            t = sample_tracker_sample(st);
-            time_tai = start_time_tai + t;
-            if (start_time_limit <= time_tai && time_tai < end_time_limit) {
-              if (last_t >= 0 && t / 1000000 != last_t / 1000000) {
-                for (c = 0; c < h_start.channel_count; ++c) {
-                  s2x_channel_flush(channels[c]);
-                }
-                st_i32_le(x, S2X_TIME);
-                st_i32_le(x + 4, 4);
-                st_i32_le(x + 8, -1);
-                st_i32_le(x + 12, start_time + t / 1000000);
-                if (fwrite(x, 16, 1, output) != 1) {
-                  fprintf(stderr, "%s", i18n->io_error);
-                  return 1;
-                }
-                have_time = 2;
+      for (k = 0; k < decoder->count; ++k) {
+        if (have_time) {
+          t = sample_tracker_sample(st);
+          time_tai = start_time_tai + t;
+          if (start_time_limit <= time_tai && time_tai < end_time_limit) {
+            if (last_t >= 0 && t / 1000000 != last_t / 1000000) {
+              for (c = 0; c < h_start.channel_count; ++c) {
+                s2x_channel_flush(channels[c]);
+              }
+              st_i32_le(x, S2X_TIME);
+              st_i32_le(x + 4, 4);
+              st_i32_le(x + 8, -1);
+              st_i32_le(x + 12, start_time + t / 1000000);
+              if (fwrite(x, 16, 1, output) != 1) {
+                fprintf(stderr, "%s", i18n->io_error);
+                return 1;
               }
-              last_t = t;
+              have_time = 2;
             }
+            last_t = t;
           }
-          if (have_time == 2) {
-            for (c = 0; c < h_start.channel_count; ++c) {
-              s2x_channel_push(channels[c], frame[c]);
-            }
+        }
+        if (have_time == 2) {
+          for (c = 0; c < h_start.channel_count; ++c) {
+            s2x_channel_push(channels[c], decoder->samples[c][k]);
           }
         }
       }
     }
-    if (progress == 1 && i % 1024 == 0) {
+    if (progress == 1) {
       fprintf(stderr, "%3d%% %6.1fMB     \r", (int) (i * 100 / h_end.address), (double) i * 512 / 1000000l);
       fflush(stderr);
     } else if (progress == 2) {
       t2 = monotonic_time();
       if (t2 - t1 >= _50ms) {
         fprintf(stderr,
-          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64"}\n",
-          (int64_t) i * 512, total, (t2 - t0) * 50 / _50ms);
+          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64"}\n",
+          (int64_t) i * 512, total, (t2 - t0) * 50 / _50ms, monotonic_throughput((int64_t) i * 512, t2 - t0));
         fflush(stderr);
         t1 = t2;
       }
     }
   }
 done:
+  blockreader_destroy(reader);
   for (c = 0; c < h_start.channel_count; ++c) {
     s2x_channel_flush(channels[c]);
   }
@@ -363,8 +437,8 @@ done:
   } else if (progress == 2) {
     t2 = monotonic_time();
     fprintf(stderr,
-          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64"}\n",
-          total, total, (t2 - t0) * 50 / _50ms);
+          "{\"done\":%"PRId64",\"total\":%"PRId64",\"elapsed\":%"PRId64",\"throughput\":%"PRId64"}\n",
+          total, total, (t2 - t0) * 50 / _50ms, monotonic_throughput(total, t2 - t0));
     fflush(stderr);
   }
 
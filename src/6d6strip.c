@@ -8,7 +8,9 @@
 #include <assert.h>
 #include <stdarg.h>
 #include "6d6.h"
+#include "decoder.h"
 #include "bcd.h"
+#include "blockreader.h"
 #include "number.h"
 #include "options.h"
 #include "version.h"
@@ -33,15 +35,6 @@ static void read_block(uint8_t *block, FILE *f)
   }
 }
 
-static int try_read_block(uint8_t *block, FILE *f)
-{
-  if (fread(block, 512, 1, f) != 1) {
-    fprintf(stderr, "%s", i18n->io_error);
-    return 1;
-  }
-  return 0;
-}
-
 static void write_or_fail(FILE *f, void *data, size_t len) {
   if (fwrite(data, len, 1, f) != 1) {
     fprintf(stderr, "%s", i18n->io_error);
@@ -77,17 +70,17 @@ int main(int argc, char **argv)
 {
   kum_6d6_header h_start, h_end;
   FILE *input = 0, *output = 0;
-  int n_channels;
-  uint8_t block[512];
+  Blockreader reader;
+  const uint8_t *data;
   uint8_t start_header_block[512];
   uint8_t end_header_block[512];
   char str[512];
   const char *filename = 0;
-  uint32_t i, j;
+  int64_t base = 0, n;
+  uint32_t i;
   int e;
-  /* Block parser. */
-  int pos, remaining = 0;
-  int32_t frame[KUM_6D6_MAX_CHANNEL_COUNT];
+  kum_6d6_decoder decoder[1];
+  const int32_t *frame;
   uint64_t frame_counter = 0;
 
   int progress = 1;
@@ -133,6 +126,7 @@ int main(int argc, char **argv)
       fprintf(stderr, "%s", i18n->malformed_6d6_header);
       exit(1);
     }
+    base = 512;
   }
   read_block(end_header_block, input);
   if (kum_6d6_header_read(&h_end, end_header_block) == -1) {
@@ -140,7 +134,10 @@ int main(int argc, char **argv)
     exit(1);
   }
 
-  n_channels = h_start.channel_count;
+  if (kum_6d6_decoder_init(decoder, h_start.channel_count)) {
+    fprintf(stderr, "%s", i18n->malformed_6d6_header);
+    exit(1);
+  }
 
   output = fopen(argv[2], "wbx");
   if (!output) {
@@ -157,59 +154,54 @@ int main(int argc, char **argv)
    * 2 x1 x2 x3 x4
    */
 
-  i = 2;
-  /* Skip to start of data.
-   * Can not fseek, because stream might not be seekable. */
-  while (i < h_start.address) {
-    read_block(block, input);
-    ++i;
+  i = h_start.address > 2 ? h_start.address : 2;
+  reader = blockreader_open(input, base + 2 * 512, base + (int64_t) i * 512, 512,
+    h_end.address > i ? h_end.address - i : 0, BLOCKREADER_CHUNK_SIZE / 512, 0, 0);
+  if (!reader) {
+    fprintf(stderr, "%s", i18n->io_error);
+    exit(1);
   }
   /* Read data. */
   while (i < h_end.address) {
-    if (try_read_block(block, input)) {
+    if (!(data = blockreader_get(reader))) {
+      fprintf(stderr, "%s", i18n->io_error);
       goto done;
     }
-    ++i;
+    n = blockreader_length(reader);
+    i += n / 512;
     /* Process block. */
-    for (j = 0; j < 512; j += 4) {
-      if (!remaining) {
-        frame[0] = ld_i32_be(block + j);
-        remaining = (frame[0] & 1) ? 3 : (n_channels - 1);
-        pos = 1;
-      } else {
-        frame[pos++] = ld_i32_be(block + j);
-        --remaining;
+    kum_6d6_decoder_feed(decoder, data, n);
+    while ((e = kum_6d6_decoder_next(decoder)) != KUM_6D6_DECODER_NEED_DATA) {
+      if (e == KUM_6D6_DECODER_SAMPLES) {
+        frame_counter += decoder->count;
+        continue;
+      }
+      if (frame_counter > 0) {
+        write_varint(output, 0);
+        write_varint(output, frame_counter);
+        frame_counter = 0;
       }
-      if (!remaining) {
-        if (frame[0] & 1) {
-          if (frame_counter > 0) {
-            write_varint(output, 0);
-            write_varint(output, frame_counter);
-            frame_counter = 0;
-          }
-          /* Control Frame */
-          if (frame[0] == 1 && frame[1] >= 0 && frame[2] >= 0 && frame[3] == 0) {
-            write_varint(output, 1);
-            write_varint(output, frame[1]);
-            write_varint(output, frame[2]);
-          } else {
-            write_varint(output, 2);
-            write_varint(output, zigzag_encode(frame[0]));
-            write_varint(output, zigzag_encode(frame[1]));
-            write_varint(output, zigzag_encode(frame[2]));
-            write_varint(output, zigzag_encode(frame[3]));
-          }
-        } else {
-          frame_counter += 1;
-        }
+      /* Control Frame */
+      frame = decoder->event.frame;
+      if (frame[0] == 1 && frame[1] >= 0 && frame[2] >= 0 && frame[3] == 0) {
+        write_varint(output, 1);
+        write_varint(output, frame[1]);
+        write_varint(output, frame[2]);
+      } else {
+        write_varint(output, 2);
+        write_varint(output, zigzag_encode(frame[0]));
+        write_varint(output, zigzag_encode(frame[1]));
+        write_varint(output, zigzag_encode(frame[2]));
+        write_varint(output, zigzag_encode(frame[3]));
       }
     }
-    if (progress && i % 1024 == 0) {
+    if (progress) {
       fprintf(stderr, "%3d%% %6.1fMB     \r", (int) (i * 100 / h_end.address), (double) i * 512 / 1000000l);
       fflush(stderr);
     }
   }
 done:
+  blockreader_destroy(reader);
   if (frame_counter > 0) {
     write_varint(output, 0);
     write_varint(output, frame_counter);
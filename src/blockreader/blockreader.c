@@ -1,89 +1,511 @@
 #define _FILE_OFFSET_BITS 64
+#define _GNU_SOURCE
 
 #include "blockreader.h"
+#include "uring.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define BLOCKREADER_THREAD 0
+#define BLOCKREADER_MMAP 1
+
+/* On 64-bit systems the whole range is mapped at once.
+ * Otherwise the range is mapped in windows of this size. */
+#define BLOCKREADER_MAP_WINDOW ((int64_t) 256 * 1024 * 1024)
+
+/* Alignment of buffers, offsets and lengths for direct I/O. */
+#define BLOCKREADER_ALIGN 4096
+
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define ADD(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_SEQ_CST)
 
 struct Blockreader {
-  pthread_t thread;
-  pthread_mutex_t lock[1];
-  pthread_cond_t condition[1];
+  int mode;
   FILE *file;
-  int done;
-  unsigned int read_buffer, write_buffer;
-  int64_t offset;
-  int64_t count;
+  int fd;
+  int close_file;
   int64_t blocksize;
+  int64_t chunk;
+  int64_t start;
+  int64_t end;
+  /* Offset and length of the last chunk returned by blockreader_get. */
+  int64_t offset;
+  int64_t length;
+  /* Memory mapped reader. */
+  int64_t page_size;
+  uint8_t *map;
+  int64_t map_offset;
+  int64_t map_length;
+  /* Threaded reader.
+   * The reader threads claim the chunks in order and every chunk has a fixed
+   * slot in the ring buffer. A slot is published by storing the chunk number
+   * plus one in `ready` and released by the consumer by advancing `tail`.
+   * The lock is only taken by a side which has to sleep and by the other side
+   * to wake it up.
+   * With io_uring a single thread keeps all reads in flight, otherwise there
+   * is one thread per read in flight. A single producer could only keep one
+   * blocking pread in flight, which does not hide the latency of a device.
+   * Because every chunk has its own slot, the producers never share a slot
+   * and the only contended word is `next`, which they claim chunks from. */
+  pthread_t *threads;
+  int thread_count;
+  struct uring uring[1];
+  struct iovec *iov;
+  pthread_mutex_t lock[1];
+  pthread_cond_t condition[1];
+  int seekable, direct, failed;
+  int64_t next, tail;
+  int running, stop;
+  int consumer_waiting, producer_waiting;
   int64_t buffer_count;
-  uint8_t buffer[1];
+  int64_t buffer_size;
+  int64_t *ready;
+  int64_t *lengths;
+  int64_t *skips;
+  uint8_t *buffer;
 };
 
-static void *blockreader_thread(void *x)
+/* Get the size of a regular file or block device.
+ * Returns -1 for pipes and other files which can not seek. */
+static int64_t blockreader_file_size(int fd, int *block_device)
 {
-  Blockreader r = x;
-  uint8_t *b;
-  int e;
+  struct stat st;
+  off_t position, size;
 
-  pthread_mutex_lock(r->lock);
-  if (fseek(r->file, r->offset, SEEK_SET))
-    r->done = 1;
-  while (!r->done) {
-    b = r->buffer + r->write_buffer * r->blocksize;
-    pthread_mutex_unlock(r->lock);
+  *block_device = 0;
+  if (fstat(fd, &st)) return -1;
+  if (S_ISREG(st.st_mode)) return st.st_size;
+  if (!S_ISBLK(st.st_mode)) return -1;
+  *block_device = 1;
+  /* Block devices do not report their size in st_size. */
+  if ((position = lseek(fd, 0, SEEK_CUR)) < 0) return -1;
+  size = lseek(fd, 0, SEEK_END);
+  if (lseek(fd, position, SEEK_SET) < 0) return -1;
+  return size < 0 ? -1 : size;
+}
 
-    e = !fread(b, r->blocksize, 1, r->file);
+static int blockreader_skip(FILE *file, int64_t position, int64_t offset, int seekable)
+{
+  uint8_t buffer[4096];
+  int64_t n;
 
-    pthread_mutex_lock(r->lock);
-    if (e) {
-      r->done = 1;
-    } else {
-      r->write_buffer = (r->write_buffer + 1) % r->buffer_count;
-      r->count -= 1;
-      if (r->count <= 0) r->done = 1;
+  /* Seek directly to the data if possible.
+   * Pipes have to be read up to the start of the data. */
+  if (seekable && position < offset && fseeko(file, offset, SEEK_SET) == 0) return 0;
+  while (position < offset) {
+    n = offset - position;
+    if (n > sizeof(buffer)) n = sizeof(buffer);
+    if (fread(buffer, n, 1, file) != 1) return -1;
+    position += n;
+  }
+  return 0;
+}
+
+/* Bypass the page cache. Returns 0 if the file system accepted it. */
+static int blockreader_direct(int fd, int on)
+{
+#if defined(O_DIRECT)
+  int flags = fcntl(fd, F_GETFL);
+  if (flags == -1) return -1;
+  return fcntl(fd, F_SETFL, on ? flags | O_DIRECT : flags & ~O_DIRECT);
+#elif defined(F_NOCACHE)
+  /* macOS has no alignment requirements, so it never has to fall back. */
+  fcntl(fd, F_NOCACHE, on);
+  return -1;
+#else
+  return -1;
+#endif
+}
+
+/* Get the range which has to be read for n bytes at the given offset. */
+static void blockreader_align(Blockreader r, int64_t offset, int64_t n, int64_t *aligned, int64_t *length)
+{
+  *aligned = offset;
+  *length = n;
+  if (LOAD(r->direct)) {
+    *aligned -= offset % BLOCKREADER_ALIGN;
+    *length = (offset - *aligned + n + BLOCKREADER_ALIGN - 1) / BLOCKREADER_ALIGN * BLOCKREADER_ALIGN;
+  }
+}
+
+/* Read n bytes at the given offset into b.
+ * With direct I/O the read starts at an aligned offset and the data starts
+ * `skip` bytes into the buffer.
+ * Returns the number of complete blocks read in bytes. */
+static int64_t blockreader_read(Blockreader r, uint8_t *b, int64_t offset, int64_t n, int64_t *skip)
+{
+  int64_t aligned, length, total = 0;
+  ssize_t x;
+
+  *skip = 0;
+  if (!r->seekable) {
+    return fread(b, r->blocksize, n / r->blocksize, r->file) * r->blocksize;
+  }
+
+retry:
+  blockreader_align(r, offset, n, &aligned, &length);
+  *skip = offset - aligned;
+  while (total < length) {
+    x = pread(r->fd, b + total, length - total, aligned + total);
+    if (x < 0 && errno == EINTR) continue;
+    if (x < 0 && errno == EINVAL && LOAD(r->direct)) {
+      /* The device does not like direct I/O after all. */
+      STORE(r->direct, 0);
+      blockreader_direct(r->fd, 0);
+      total = 0;
+      goto retry;
     }
+    if (x <= 0) break;
+    total += x;
+    /* Short reads only happen at the end of the file. */
+    if (LOAD(r->direct)) break;
+  }
+  total -= *skip;
+  if (total < 0) total = 0;
+  if (total > n) total = n;
+  return total / r->blocksize * r->blocksize;
+}
+
+static void blockreader_wake(Blockreader r, int *waiting)
+{
+  if (LOAD(*waiting)) {
+    pthread_mutex_lock(r->lock);
     pthread_cond_broadcast(r->condition);
-    while (!r->done && r->count && ((r->write_buffer + 1) % r->buffer_count) == r->read_buffer) {
+    pthread_mutex_unlock(r->lock);
+  }
+}
+
+static int64_t blockreader_chunk_count(Blockreader r)
+{
+  return (r->end - r->start + r->blocksize * r->chunk - 1) / (r->blocksize * r->chunk);
+}
+
+/* Wait until the slot for chunk k is free.
+ * Returns -1 if the Blockreader is being destroyed. */
+static int blockreader_wait_slot(Blockreader r, int64_t k)
+{
+  if (k - LOAD(r->tail) >= r->buffer_count) {
+    pthread_mutex_lock(r->lock);
+    ADD(r->producer_waiting, 1);
+    while (k - LOAD(r->tail) >= r->buffer_count && !LOAD(r->stop)) {
       pthread_cond_wait(r->condition, r->lock);
     }
+    ADD(r->producer_waiting, -1);
+    pthread_mutex_unlock(r->lock);
   }
+  return LOAD(r->stop) ? -1 : 0;
+}
+
+static void blockreader_publish(Blockreader r, int64_t k, int64_t length, int64_t skip)
+{
+  int64_t slot = k % r->buffer_count;
+  r->lengths[slot] = length;
+  r->skips[slot] = skip;
+  STORE(r->ready[slot], k + 1);
+  blockreader_wake(r, &r->consumer_waiting);
+}
+
+/* Get offset and length of chunk k. */
+static int64_t blockreader_chunk(Blockreader r, int64_t k, int64_t *n)
+{
+  int64_t offset = r->start + k * r->blocksize * r->chunk;
+  *n = r->end - offset;
+  if (*n > r->blocksize * r->chunk) *n = r->blocksize * r->chunk;
+  return offset;
+}
+
+static void blockreader_exit(Blockreader r)
+{
+  ADD(r->running, -1);
+  pthread_mutex_lock(r->lock);
+  pthread_cond_broadcast(r->condition);
   pthread_mutex_unlock(r->lock);
+}
+
+static void *blockreader_thread(void *x)
+{
+  Blockreader r = x;
+  int64_t k, offset, n, m, skip;
+  int64_t chunks = blockreader_chunk_count(r);
 
-  fclose(r->file);
+  while ((k = ADD(r->next, 1)) < chunks) {
+    if (blockreader_wait_slot(r, k)) break;
+    offset = blockreader_chunk(r, k, &n);
+    m = blockreader_read(r, r->buffer + k % r->buffer_count * r->buffer_size, offset, n, &skip);
+    blockreader_publish(r, k, m, skip);
+    if (m < n) break;
+  }
 
+  blockreader_exit(r);
   return 0;
 }
 
-extern Blockreader blockreader_new(const char *filename, int64_t start_offset, int64_t blocksize, int64_t count, int64_t buffer_count)
+/* Reader thread for io_uring. Reads are submitted as soon as a slot is
+ * free and published in any order as they complete. */
+static void *blockreader_uring_thread(void *x)
 {
-  Blockreader r;
+  Blockreader r = x;
+  int64_t k, slot, offset, aligned, n, m, skip, in_flight = 0;
+  int64_t chunks = blockreader_chunk_count(r);
+  uint64_t data;
+  int32_t res;
+  int error = 0;
 
-  if (!filename || start_offset < 0 || blocksize < 1 || count < 0 || buffer_count < 2) return 0;
+  for (;;) {
+    /* Stop submitting after an error or when the Blockreader is destroyed,
+     * but wait for all reads in flight, because they write to the buffers. */
+    while (!error && r->next < chunks && !LOAD(r->stop) &&
+        in_flight < r->buffer_count - 1 && r->next - LOAD(r->tail) < r->buffer_count) {
+      k = r->next;
+      slot = k % r->buffer_count;
+      offset = blockreader_chunk(r, k, &n);
+      blockreader_align(r, offset, n, &aligned, &r->lengths[slot]);
+      r->iov[slot].iov_base = r->buffer + slot * r->buffer_size;
+      r->iov[slot].iov_len = r->lengths[slot];
+      if (uring_readv(r->uring, r->fd, &r->iov[slot], aligned, k)) break;
+      r->skips[slot] = offset - aligned;
+      r->next += 1;
+      in_flight += 1;
+    }
+    if (!in_flight) {
+      if (r->next >= chunks || blockreader_wait_slot(r, r->next)) break;
+      /* After an error the first chunk which was not read is published
+       * empty, so the consumer sees an I/O error instead of the end. */
+      if (error) {
+        blockreader_publish(r, r->next, 0, 0);
+        break;
+      }
+      continue;
+    }
+    if (uring_wait(r->uring)) {
+      /* Take back the reads which never reached the kernel. The others
+       * still write to the buffers, so they are reaped before giving up.
+       * If the ring keeps failing, poll for their completions. */
+      if (error) usleep(1000);
+      k = uring_cancel(r->uring);
+      r->next -= k;
+      in_flight -= k;
+      error = 1;
+    }
+    while (uring_complete(r->uring, &data, &res)) {
+      k = data;
+      slot = k % r->buffer_count;
+      offset = blockreader_chunk(r, k, &n);
+      skip = r->skips[slot];
+      if (res >= skip + n) {
+        m = n;
+      } else {
+        /* Short reads and errors are retried synchronously. This also
+         * takes care of devices which reject direct I/O. */
+        m = blockreader_read(r, r->buffer + slot * r->buffer_size, offset, n, &skip);
+      }
+      in_flight -= 1;
+      blockreader_publish(r, k, m, skip);
+      /* Completions come in any order, so keep the earliest short read. */
+      if (m < n && k + 1 < chunks) chunks = k + 1;
+    }
+  }
+
+  blockreader_exit(r);
+  return 0;
+}
 
-  r = malloc(sizeof(struct Blockreader) - 1 + blocksize * buffer_count);
+static Blockreader blockreader_alloc(FILE *file, int64_t start_offset, int64_t blocksize, int64_t count, int64_t chunk)
+{
+  Blockreader r = malloc(sizeof(struct Blockreader));
   if (!r) return 0;
 
-  r->done = 0;
-  r->read_buffer = 0;
-  r->write_buffer = 0;
-  r->offset = start_offset;
+  r->file = file;
+  r->fd = fileno(file);
+  r->close_file = 0;
   r->blocksize = blocksize;
-  r->count = count;
-  r->buffer_count = buffer_count;
+  r->chunk = chunk;
+  r->start = start_offset;
+  r->end = start_offset + blocksize * count;
+  r->offset = start_offset;
+  r->length = 0;
+  r->map = 0;
+  r->map_offset = 0;
+  r->map_length = 0;
+  r->seekable = 0;
+  r->direct = 0;
+  r->buffer = 0;
+  r->ready = 0;
+  r->lengths = 0;
+  r->skips = 0;
+  r->iov = 0;
+  r->threads = 0;
+  /* uring_destroy runs for every threaded reader, also when uring_init was
+   * never called for pipes. */
+  r->uring->fd = -1;
+  r->uring->sq_ring = r->uring->cq_ring = r->uring->sqes = MAP_FAILED;
 
-  if (!(r->file = fopen(filename, "rb"))) {
-    free(r);
-    return 0;
+  return r;
+}
+
+static void blockreader_free_buffers(Blockreader r)
+{
+  free(r->buffer);
+  free(r->ready);
+  free(r->lengths);
+  free(r->skips);
+  free(r->iov);
+  free(r->threads);
+}
+
+/* Start reading with `queue_depth` reads in flight.
+ * Files which can not seek are always read by a single thread. */
+static int blockreader_start(Blockreader r, int64_t queue_depth)
+{
+  void *buffer;
+  int64_t i, thread_count;
+
+  r->mode = BLOCKREADER_THREAD;
+  r->failed = 0;
+  r->next = r->tail = 0;
+  r->stop = 0;
+  r->consumer_waiting = r->producer_waiting = 0;
+  /* The consumer holds one buffer while the others are read. */
+  r->buffer_count = queue_depth + 1;
+  r->buffer_size = r->blocksize * r->chunk;
+  if (r->direct) {
+    /* Leave room for aligning the start and the end of a read. */
+    r->buffer_size += 2 * BLOCKREADER_ALIGN;
+    r->buffer_size += BLOCKREADER_ALIGN - r->buffer_size % BLOCKREADER_ALIGN;
+  }
+  r->ready = malloc(sizeof(*r->ready) * r->buffer_count);
+  r->lengths = malloc(sizeof(*r->lengths) * r->buffer_count);
+  r->skips = malloc(sizeof(*r->skips) * r->buffer_count);
+  r->iov = malloc(sizeof(*r->iov) * r->buffer_count);
+  r->threads = malloc(sizeof(*r->threads) * queue_depth);
+  if (posix_memalign(&buffer, BLOCKREADER_ALIGN, r->buffer_size * r->buffer_count)) buffer = 0;
+  r->buffer = buffer;
+  if (!r->buffer || !r->ready || !r->lengths || !r->skips || !r->iov || !r->threads) goto fail;
+  for (i = 0; i < r->buffer_count; ++i) {
+    r->ready[i] = 0;
   }
 
   pthread_mutex_init(r->lock, 0);
   pthread_cond_init(r->condition, 0);
 
-  if (pthread_create(&r->thread, 0, blockreader_thread, r)) {
-    pthread_cond_destroy(r->condition);
-    pthread_mutex_destroy(r->lock);
-    fclose(r->file);
+  r->running = 0;
+  r->thread_count = 0;
+  if (r->seekable && uring_init(r->uring, queue_depth) == 0) {
+    ADD(r->running, 1);
+    if (pthread_create(&r->threads[0], 0, blockreader_uring_thread, r) == 0) {
+      r->thread_count = 1;
+      return 0;
+    }
+    ADD(r->running, -1);
+    uring_destroy(r->uring);
+  }
+  thread_count = r->seekable ? queue_depth : 1;
+  for (r->thread_count = 0; r->thread_count < thread_count; ++r->thread_count) {
+    ADD(r->running, 1);
+    if (pthread_create(&r->threads[r->thread_count], 0, blockreader_thread, r)) {
+      ADD(r->running, -1);
+      break;
+    }
+  }
+  if (r->thread_count) return 0;
+
+  pthread_cond_destroy(r->condition);
+  pthread_mutex_destroy(r->lock);
+fail:
+  blockreader_free_buffers(r);
+  return -1;
+}
+
+extern Blockreader blockreader_new(const char *filename, int64_t start_offset, int64_t blocksize, int64_t count, int64_t buffer_count)
+{
+  Blockreader r;
+  FILE *file;
+
+  if (!filename || start_offset < 0 || blocksize < 1 || count < 0 || buffer_count < 2) return 0;
+
+  if (!(file = fopen(filename, "rb"))) return 0;
+  if (fseeko(file, start_offset, SEEK_SET) || !(r = blockreader_alloc(file, start_offset, blocksize, count, 1))) {
+    fclose(file);
+    return 0;
+  }
+  r->close_file = 1;
+
+  if (blockreader_start(r, buffer_count - 1)) {
+    fclose(file);
+    free(r);
+    return 0;
+  }
+
+  return r;
+}
+
+static int blockreader_map(Blockreader r, int64_t offset)
+{
+  int64_t window;
+
+  if (r->map) munmap(r->map, r->map_length);
+  r->map = 0;
+  window = sizeof(void *) >= 8 ? r->end : BLOCKREADER_MAP_WINDOW;
+  r->map_offset = offset - offset % r->page_size;
+  r->map_length = r->end - r->map_offset;
+  if (r->map_length > window) r->map_length = window;
+  r->map = mmap(0, r->map_length, PROT_READ, MAP_SHARED, fileno(r->file), r->map_offset);
+  if (r->map == MAP_FAILED) {
+    r->map = 0;
+    return -1;
+  }
+  madvise(r->map, r->map_length, MADV_SEQUENTIAL);
+  return 0;
+}
+
+extern Blockreader blockreader_open(FILE *file, int64_t position, int64_t start_offset, int64_t blocksize, int64_t count, int64_t chunk, int64_t queue_depth, int flags)
+{
+  Blockreader r;
+  int64_t size;
+  int block_device;
+
+  if (!file || position < 0 || start_offset < position || blocksize < 1 || count < 0 || chunk < 1) return 0;
+  if (queue_depth < 1) queue_depth = BLOCKREADER_QUEUE_DEPTH;
+  if (queue_depth > BLOCKREADER_MAX_QUEUE_DEPTH) return 0;
+
+  size = blockreader_file_size(fileno(file), &block_device);
+
+  if (!(r = blockreader_alloc(file, start_offset, blocksize, count, chunk))) return 0;
+
+  /* Regular files are memory mapped.
+   * Block devices are read ahead by threads to hide their latency. */
+  if (size >= 0 && !block_device && !(flags & BLOCKREADER_DIRECT)) {
+    r->mode = BLOCKREADER_MMAP;
+    r->page_size = sysconf(_SC_PAGESIZE);
+    if (r->page_size < 1) r->page_size = 4096;
+    /* Never map beyond the end of the file. */
+    if (size < r->end) {
+      r->end = start_offset + (size > start_offset ? (size - start_offset) / blocksize * blocksize : 0);
+    }
+    if (r->end <= start_offset || blockreader_map(r, start_offset) == 0) return r;
+    /* Not every file system supports mmap. */
+    r->end = start_offset + blocksize * count;
+  }
+
+  r->seekable = size >= 0;
+  if (r->seekable && (flags & BLOCKREADER_DIRECT)) {
+    r->direct = blockreader_direct(r->fd, 1) == 0;
+  }
+
+  if (blockreader_skip(file, position, start_offset, r->seekable) ||
+      blockreader_start(r, queue_depth)) {
     free(r);
     return 0;
   }
@@ -91,62 +513,176 @@ extern Blockreader blockreader_new(const char *filename, int64_t start_offset, i
   return r;
 }
 
+/* Reading a mapped page which is gone, because the file was truncated or the
+ * device failed, raises SIGBUS. While the pages of a chunk are touched the
+ * handler jumps back and the chunk is reported as an I/O error. Any other
+ * SIGBUS is passed on to the previous action. */
+static __thread sigjmp_buf *volatile blockreader_fault;
+static struct sigaction blockreader_sigbus_action;
+static pthread_once_t blockreader_sigbus_once = PTHREAD_ONCE_INIT;
+
+static void blockreader_sigbus(int number)
+{
+  if (blockreader_fault) siglongjmp(*blockreader_fault, 1);
+  /* The fault happens again on return and now takes the previous action. */
+  sigaction(SIGBUS, &blockreader_sigbus_action, 0);
+}
+
+static void blockreader_sigbus_install(void)
+{
+  struct sigaction action;
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = blockreader_sigbus;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGBUS, &action, &blockreader_sigbus_action);
+}
+
+/* Touch every page of n bytes at p. Returns -1 if one can not be read. */
+static int blockreader_probe(Blockreader r, const uint8_t *p, int64_t n)
+{
+  const volatile uint8_t *v = p;
+  sigjmp_buf jump;
+  int64_t i;
+
+  pthread_once(&blockreader_sigbus_once, blockreader_sigbus_install);
+  if (sigsetjmp(jump, 1)) {
+    blockreader_fault = 0;
+    return -1;
+  }
+  blockreader_fault = &jump;
+  for (i = 0; i < n; i += r->page_size) {
+    (void) v[i];
+  }
+  (void) v[n - 1];
+  blockreader_fault = 0;
+  return 0;
+}
+
+static const uint8_t *blockreader_get_mmap(Blockreader r)
+{
+  int64_t n;
+
+  r->offset += r->length;
+  r->length = 0;
+  n = r->end - r->offset;
+  if (n > r->blocksize * r->chunk) n = r->blocksize * r->chunk;
+  if (n <= 0) return 0;
+  if (!r->map || r->offset + n > r->map_offset + r->map_length) {
+    if (blockreader_map(r, r->offset)) return 0;
+    if (r->offset + n > r->map_offset + r->map_length) {
+      n = (r->map_offset + r->map_length - r->offset) / r->blocksize * r->blocksize;
+    }
+  }
+  if (blockreader_probe(r, r->map + (r->offset - r->map_offset), n)) return 0;
+  r->length = n;
+  return r->map + (r->offset - r->map_offset);
+}
+
 extern const uint8_t *blockreader_get(Blockreader r)
 {
-  uint8_t *b = 0;
+  int64_t slot;
 
   if (!r) return 0;
 
-  pthread_mutex_lock(r->lock);
-  while (r->read_buffer == r->write_buffer) {
-    if (r->done) goto end;
-    pthread_cond_wait(r->condition, r->lock);
-  }
-  b = r->buffer + r->read_buffer * r->blocksize;
-  r->read_buffer = (r->read_buffer + 1) % r->buffer_count;
-  r->offset += r->blocksize;
-end:
-  pthread_cond_broadcast(r->condition);
-  pthread_mutex_unlock(r->lock);
-  return b;
+  if (r->mode == BLOCKREADER_MMAP) return blockreader_get_mmap(r);
+
+  /* Release the last chunk. A short chunk ends the data. */
+  if (r->length) {
+    r->offset += r->length;
+    r->failed = r->length < r->blocksize * r->chunk;
+    r->length = 0;
+    STORE(r->tail, r->tail + 1);
+    blockreader_wake(r, &r->producer_waiting);
+  }
+  if (r->failed || r->offset >= r->end) return 0;
+
+  /* Wait for the next chunk. */
+  slot = r->tail % r->buffer_count;
+  if (LOAD(r->ready[slot]) != r->tail + 1) {
+    pthread_mutex_lock(r->lock);
+    STORE(r->consumer_waiting, 1);
+    while (LOAD(r->ready[slot]) != r->tail + 1 && LOAD(r->running)) {
+      pthread_cond_wait(r->condition, r->lock);
+    }
+    STORE(r->consumer_waiting, 0);
+    pthread_mutex_unlock(r->lock);
+    if (LOAD(r->ready[slot]) != r->tail + 1) return 0;
+  }
+
+  r->length = r->lengths[slot];
+  if (!r->length) return 0;
+  return r->buffer + slot * r->buffer_size + r->skips[slot];
 }
 
 extern int64_t blockreader_offset(Blockreader r)
 {
-  int64_t offset;
-
   if (!r) return -1;
-
-  pthread_mutex_lock(r->lock);
-  offset = r->offset;
-  pthread_mutex_unlock(r->lock);
-  return offset;
+  return r->offset;
 }
 
 extern int64_t blockreader_length(Blockreader r)
 {
-  int64_t blocksize;
-
   if (!r) return -1;
-
-  pthread_mutex_lock(r->lock);
-  blocksize = r->blocksize;
-  pthread_mutex_unlock(r->lock);
-  return blocksize;
+  return r->length;
 }
 
 extern void blockreader_destroy(Blockreader r)
 {
   if (!r) return;
 
-  pthread_mutex_lock(r->lock);
-  r->done = 1;
-  pthread_cond_broadcast(r->condition);
-  pthread_mutex_unlock(r->lock);
+  if (r->mode == BLOCKREADER_THREAD) {
+    STORE(r->stop, 1);
+    pthread_mutex_lock(r->lock);
+    pthread_cond_broadcast(r->condition);
+    pthread_mutex_unlock(r->lock);
 
-  pthread_join(r->thread, 0);
+    while (r->thread_count) {
+      pthread_join(r->threads[--r->thread_count], 0);
+    }
 
-  pthread_mutex_destroy(r->lock);
-  pthread_cond_destroy(r->condition);
+    uring_destroy(r->uring);
+    pthread_mutex_destroy(r->lock);
+    pthread_cond_destroy(r->condition);
+    blockreader_free_buffers(r);
+  }
+
+  if (r->map) munmap(r->map, r->map_length);
+  if (r->close_file) fclose(r->file);
   free(r);
 }
+
+extern int blockreader_parse_size(const char *s, int64_t *size)
+{
+  int64_t n = 0, unit = 1;
+
+  if (!s || *s < '0' || *s > '9') return -1;
+  while (*s >= '0' && *s <= '9') {
+    if (__builtin_mul_overflow(n, 10, &n)) return -1;
+    if (__builtin_add_overflow(n, *s - '0', &n)) return -1;
+    ++s;
+  }
+  switch (*s) {
+    case 'k': case 'K': unit = 1024; ++s; break;
+    case 'm': case 'M': unit = 1024 * 1024; ++s; break;
+    case 'g': case 'G': unit = 1024 * 1024 * 1024; ++s; break;
+  }
+  if (*s || __builtin_mul_overflow(n, unit, &n)) return -1;
+  *size = n;
+  return 0;
+}
+
+extern int blockreader_parse_number(const char *s, int64_t *number)
+{
+  int64_t n = 0;
+
+  if (!s || !*s) return -1;
+  while (*s >= '0' && *s <= '9') {
+    if (__builtin_mul_overflow(n, 10, &n)) return -1;
+    if (__builtin_add_overflow(n, *s - '0', &n)) return -1;
+    ++s;
+  }
+  if (*s) return -1;
+  *number = n;
+  return 0;
+}
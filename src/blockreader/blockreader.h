@@ -1,12 +1,49 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 
 typedef struct Blockreader *Blockreader;
 
+/* Default size of the chunks returned by blockreader_get in bytes. */
+#define BLOCKREADER_CHUNK_SIZE (4 * 1024 * 1024)
+#define BLOCKREADER_MAX_CHUNK_SIZE (256 * 1024 * 1024)
+
+/* Default and maximum number of reads in flight. */
+#define BLOCKREADER_QUEUE_DEPTH 4
+#define BLOCKREADER_MAX_QUEUE_DEPTH 64
+
+/* Flags for blockreader_open. */
+/* Bypass the page cache when reading from a file or block device.
+ * Falls back to normal reads if direct I/O is not supported. */
+#define BLOCKREADER_DIRECT 1
+
 /* Create a new Blockreader. */
 extern Blockreader blockreader_new(const char *filename, int64_t start_offset, int64_t blocksize, int64_t count, int64_t buffer_count);
 
+/* Create a Blockreader for an already opened file.
+ * The file must be positioned at `position`, which may not lie behind
+ * `start_offset`. The Blockreader reads `count` blocks of `blocksize` bytes
+ * starting at `start_offset` and returns up to `chunk` blocks at once.
+ * Regular files are memory mapped. The pages of every chunk are touched
+ * before it is returned, and a file which shrinks or fails to read at that
+ * point is reported as an error; a SIGBUS handler is installed for this.
+ * A file which shrinks while the caller works on a chunk still raises SIGBUS.
+ * Block devices and pipes are read ahead
+ * into a ring buffer of chunks. Up to `queue_depth` reads are kept in flight
+ * using io_uring or, if that is not available, one thread per read.
+ * Pipes are read by a single thread. A `queue_depth` of 0 selects the default.
+ * In case of an error NULL is returned. */
+extern Blockreader blockreader_open(FILE *file, int64_t position, int64_t start_offset, int64_t blocksize, int64_t count, int64_t chunk, int64_t queue_depth, int flags);
+
+/* Parse a size like "4M" or "512k" for options like --chunk-size.
+ * Returns 0 on success and -1 if the string is not a valid size. */
+extern int blockreader_parse_size(const char *s, int64_t *size);
+
+/* Parse a plain decimal number for options like --queue-depth.
+ * Returns 0 on success and -1 if the string is not a valid number. */
+extern int blockreader_parse_number(const char *s, int64_t *number);
+
 /* Get the next block.
  * The pointer is valid until blockreader_get is called again
  * or the Blockreader is destroyed by blockreader_destroy.
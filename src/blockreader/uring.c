@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+
+#include "uring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING
+#endif
+#endif
+
+#ifdef HAVE_IO_URING
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define ACQUIRE(x) __atomic_load_n(x, __ATOMIC_ACQUIRE)
+#define RELEASE(x, v) __atomic_store_n(x, v, __ATOMIC_RELEASE)
+
+extern int uring_init(struct uring *u, unsigned entries)
+{
+  struct io_uring_params p;
+
+  memset(u, 0, sizeof(*u));
+  memset(&p, 0, sizeof(p));
+  u->sq_ring = u->cq_ring = u->sqes = MAP_FAILED;
+
+  u->fd = syscall(__NR_io_uring_setup, entries, &p);
+  if (u->fd < 0) return -1;
+  u->entries = p.sq_entries;
+
+  u->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  u->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  /* Newer kernels map both rings at once. */
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (u->cq_ring_size > u->sq_ring_size) u->sq_ring_size = u->cq_ring_size;
+    u->cq_ring_size = u->sq_ring_size;
+  }
+  u->sq_ring = mmap(0, u->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+  if (u->sq_ring == MAP_FAILED) goto fail;
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    u->cq_ring = u->sq_ring;
+  } else {
+    u->cq_ring = mmap(0, u->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+    if (u->cq_ring == MAP_FAILED) goto fail;
+  }
+  u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  u->sqes = mmap(0, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+  if (u->sqes == MAP_FAILED) goto fail;
+
+  u->sq_head = (unsigned *) ((char *) u->sq_ring + p.sq_off.head);
+  u->sq_tail = (unsigned *) ((char *) u->sq_ring + p.sq_off.tail);
+  u->sq_mask = (unsigned *) ((char *) u->sq_ring + p.sq_off.ring_mask);
+  u->sq_array = (unsigned *) ((char *) u->sq_ring + p.sq_off.array);
+  u->cq_head = (unsigned *) ((char *) u->cq_ring + p.cq_off.head);
+  u->cq_tail = (unsigned *) ((char *) u->cq_ring + p.cq_off.tail);
+  u->cq_mask = (unsigned *) ((char *) u->cq_ring + p.cq_off.ring_mask);
+  u->cqes = (char *) u->cq_ring + p.cq_off.cqes;
+
+  return 0;
+
+fail:
+  uring_destroy(u);
+  return -1;
+}
+
+extern int uring_readv(struct uring *u, int fd, const struct iovec *iov, int64_t offset, uint64_t data)
+{
+  struct io_uring_sqe *sqe;
+  unsigned tail = *u->sq_tail, index;
+
+  if (tail - ACQUIRE(u->sq_head) >= u->entries) return -1;
+  index = tail & *u->sq_mask;
+  sqe = (struct io_uring_sqe *) u->sqes + index;
+  /* IORING_OP_READV is available since the first kernel with io_uring. */
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t) (uintptr_t) iov;
+  sqe->len = 1;
+  sqe->off = offset;
+  sqe->user_data = data;
+  u->sq_array[index] = index;
+  RELEASE(u->sq_tail, tail + 1);
+  u->pending += 1;
+  return 0;
+}
+
+extern int uring_wait(struct uring *u)
+{
+  int x;
+
+  for (;;) {
+    x = syscall(__NR_io_uring_enter, u->fd, u->pending, 1, IORING_ENTER_GETEVENTS, 0, 0);
+    if (x >= 0) break;
+    if (errno != EINTR) return -1;
+  }
+  u->pending -= x;
+  return 0;
+}
+
+extern unsigned uring_cancel(struct uring *u)
+{
+  unsigned head = ACQUIRE(u->sq_head), n = *u->sq_tail - head;
+
+  RELEASE(u->sq_tail, head);
+  u->pending = 0;
+  return n;
+}
+
+extern int uring_complete(struct uring *u, uint64_t *data, int32_t *res)
+{
+  struct io_uring_cqe *cqe;
+  unsigned head = *u->cq_head;
+
+  if (head == ACQUIRE(u->cq_tail)) return 0;
+  cqe = (struct io_uring_cqe *) u->cqes + (head & *u->cq_mask);
+  *data = cqe->user_data;
+  *res = cqe->res;
+  RELEASE(u->cq_head, head + 1);
+  return 1;
+}
+
+extern void uring_destroy(struct uring *u)
+{
+  if (u->sqes != MAP_FAILED) munmap(u->sqes, u->sqes_size);
+  if (u->cq_ring != MAP_FAILED && u->cq_ring != u->sq_ring) munmap(u->cq_ring, u->cq_ring_size);
+  if (u->sq_ring != MAP_FAILED) munmap(u->sq_ring, u->sq_ring_size);
+  if (u->fd >= 0) close(u->fd);
+  u->fd = -1;
+  u->sq_ring = u->cq_ring = u->sqes = MAP_FAILED;
+}
+
+#else
+
+extern int uring_init(struct uring *u, unsigned entries)
+{
+  u->fd = -1;
+  return -1;
+}
+
+extern int uring_readv(struct uring *u, int fd, const struct iovec *iov, int64_t offset, uint64_t data)
+{
+  return -1;
+}
+
+extern int uring_wait(struct uring *u)
+{
+  return -1;
+}
+
+extern unsigned uring_cancel(struct uring *u)
+{
+  return 0;
+}
+
+extern int uring_complete(struct uring *u, uint64_t *data, int32_t *res)
+{
+  return 0;
+}
+
+extern void uring_destroy(struct uring *u)
+{
+}
+
+#endif
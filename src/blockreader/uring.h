@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+/* A minimal io_uring used by the Blockreader to keep several reads in flight.
+ * It talks to the kernel directly, so liburing is not needed.
+ * On systems without io_uring uring_init always fails. */
+struct uring {
+  int fd;
+  unsigned entries;
+  /* Submissions which were queued but not yet passed to the kernel. */
+  unsigned pending;
+  void *sq_ring, *cq_ring, *sqes, *cqes;
+  size_t sq_ring_size, cq_ring_size, sqes_size;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+};
+
+/* Set up a ring for up to `entries` reads in flight.
+ * Returns 0 on success and -1 if io_uring is not available. */
+extern int uring_init(struct uring *u, unsigned entries);
+
+/* Queue a read of `iov` from `fd` at `offset`.
+ * `data` is returned with the completion. Returns -1 if the ring is full. */
+extern int uring_readv(struct uring *u, int fd, const struct iovec *iov, int64_t offset, uint64_t data);
+
+/* Submit all queued reads and wait for at least one completion. */
+extern int uring_wait(struct uring *u);
+
+/* Take back all queued reads which the kernel has not picked up yet.
+ * These are always the last ones queued. Returns their number. */
+extern unsigned uring_cancel(struct uring *u);
+
+/* Get the next completion. Returns 0 if there is none.
+ * `res` is the number of bytes read or a negative error number. */
+extern int uring_complete(struct uring *u, uint64_t *data, int32_t *res);
+
+/* Free all resources of the ring. */
+extern void uring_destroy(struct uring *u);
@@ -0,0 +1,130 @@
+#include "checksum.h"
+#include "crc32c.h"
+#include "sha256.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct Checksum {
+  int algorithms;
+  int64_t length;
+  uint32_t crc;
+  sha256_context sha[1];
+  pthread_t thread;
+  pthread_mutex_t lock[1];
+  pthread_cond_t condition[1];
+  /* The data to be hashed. Set by checksum_start and cleared by the thread. */
+  const uint8_t *data;
+  int64_t data_length;
+  int stop;
+};
+
+static void checksum_hash(Checksum c, const uint8_t *data, int64_t length)
+{
+  if (c->algorithms & CHECKSUM_CRC32C) c->crc = crc32c_update(c->crc, data, length);
+  if (c->algorithms & CHECKSUM_SHA256) sha256_update(c->sha, data, length);
+  c->length += length;
+}
+
+static void *checksum_thread(void *x)
+{
+  Checksum c = x;
+
+  pthread_mutex_lock(c->lock);
+  for (;;) {
+    while (!c->data && !c->stop) pthread_cond_wait(c->condition, c->lock);
+    if (c->stop) break;
+    pthread_mutex_unlock(c->lock);
+    checksum_hash(c, c->data, c->data_length);
+    pthread_mutex_lock(c->lock);
+    c->data = 0;
+    pthread_cond_broadcast(c->condition);
+  }
+  pthread_mutex_unlock(c->lock);
+
+  return 0;
+}
+
+extern Checksum checksum_new(int algorithms)
+{
+  Checksum c = malloc(sizeof(struct Checksum));
+  if (!c) return 0;
+
+  c->algorithms = algorithms;
+  c->length = 0;
+  c->crc = 0;
+  sha256_init(c->sha);
+  c->data = 0;
+  c->data_length = 0;
+  c->stop = 0;
+  pthread_mutex_init(c->lock, 0);
+  pthread_cond_init(c->condition, 0);
+  if (pthread_create(&c->thread, 0, checksum_thread, c)) {
+    pthread_cond_destroy(c->condition);
+    pthread_mutex_destroy(c->lock);
+    free(c);
+    return 0;
+  }
+
+  return c;
+}
+
+extern void checksum_start(Checksum c, const uint8_t *data, int64_t length)
+{
+  if (!length) return;
+  pthread_mutex_lock(c->lock);
+  c->data = data;
+  c->data_length = length;
+  pthread_cond_broadcast(c->condition);
+  pthread_mutex_unlock(c->lock);
+}
+
+extern void checksum_wait(Checksum c)
+{
+  pthread_mutex_lock(c->lock);
+  while (c->data) pthread_cond_wait(c->condition, c->lock);
+  pthread_mutex_unlock(c->lock);
+}
+
+extern void checksum_update(Checksum c, const uint8_t *data, int64_t length)
+{
+  checksum_start(c, data, length);
+  checksum_wait(c);
+}
+
+extern int64_t checksum_length(Checksum c)
+{
+  return c->length;
+}
+
+extern uint32_t checksum_crc32c(Checksum c)
+{
+  return c->crc;
+}
+
+extern void checksum_sha256(Checksum c, char hex[65])
+{
+  uint8_t digest[32];
+  int i;
+
+  sha256_final(c->sha, digest);
+  for (i = 0; i < 32; ++i) {
+    snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+  }
+}
+
+extern void checksum_destroy(Checksum c)
+{
+  if (!c) return;
+
+  pthread_mutex_lock(c->lock);
+  c->stop = 1;
+  pthread_cond_broadcast(c->condition);
+  pthread_mutex_unlock(c->lock);
+  pthread_join(c->thread, 0);
+
+  pthread_cond_destroy(c->condition);
+  pthread_mutex_destroy(c->lock);
+  free(c);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef struct Checksum *Checksum;
+
+/* Algorithms for checksum_new. */
+#define CHECKSUM_CRC32C 1
+#define CHECKSUM_SHA256 2
+
+/* Create a new Checksum for the given algorithms.
+ * The data is hashed by a separate thread.
+ * In case of an error NULL is returned. */
+extern Checksum checksum_new(int algorithms);
+
+/* Start hashing `length` bytes of data in the background.
+ * The data must stay valid until checksum_wait returns. */
+extern void checksum_start(Checksum c, const uint8_t *data, int64_t length);
+
+/* Wait until the data given to checksum_start is hashed. */
+extern void checksum_wait(Checksum c);
+
+/* Hash `length` bytes of data and wait for the result. */
+extern void checksum_update(Checksum c, const uint8_t *data, int64_t length);
+
+/* Get the number of bytes hashed so far. */
+extern int64_t checksum_length(Checksum c);
+
+/* Get the CRC32C of all data so far. */
+extern uint32_t checksum_crc32c(Checksum c);
+
+/* Get the SHA-256 of all data so far as 64 hex digits.
+ * This finishes the hash, so no more data may be added afterwards. */
+extern void checksum_sha256(Checksum c, char hex[65]);
+
+/* Destroy the Checksum and free all of its resources. */
+extern void checksum_destroy(Checksum c);
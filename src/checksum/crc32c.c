@@ -0,0 +1,124 @@
+#include "crc32c.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define CRC32C_POLY 0x82f63b78
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+static uint32_t (*crc32c_function)(uint32_t crc, const uint8_t *p, size_t n);
+
+/* Table driven CRC, eight bytes at a time. */
+static uint32_t crc32c_soft(uint32_t crc, const uint8_t *p, size_t n)
+{
+  uint32_t a, b;
+
+  while (n && ((uintptr_t) p & 7)) {
+    crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    n -= 1;
+  }
+  while (n >= 8) {
+    a = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24);
+    b = p[4] | p[5] << 8 | p[6] << 16 | (uint32_t) p[7] << 24;
+    crc = crc32c_table[7][a & 0xff] ^ crc32c_table[6][(a >> 8) & 0xff] ^
+      crc32c_table[5][(a >> 16) & 0xff] ^ crc32c_table[4][a >> 24] ^
+      crc32c_table[3][b & 0xff] ^ crc32c_table[2][(b >> 8) & 0xff] ^
+      crc32c_table[1][(b >> 16) & 0xff] ^ crc32c_table[0][b >> 24];
+    p += 8;
+    n -= 8;
+  }
+  while (n) {
+    crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    n -= 1;
+  }
+  return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32C_HARDWARE
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hardware(uint32_t crc, const uint8_t *p, size_t n)
+{
+  uint64_t c = crc, x;
+
+  while (n && ((uintptr_t) p & 7)) {
+    c = __builtin_ia32_crc32qi(c, *p++);
+    n -= 1;
+  }
+  while (n >= 8) {
+    memcpy(&x, p, 8);
+    c = __builtin_ia32_crc32di(c, x);
+    p += 8;
+    n -= 8;
+  }
+  while (n) {
+    c = __builtin_ia32_crc32qi(c, *p++);
+    n -= 1;
+  }
+  return c;
+}
+
+static int crc32c_have_hardware(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32C_HARDWARE
+#include <arm_acle.h>
+static uint32_t crc32c_hardware(uint32_t crc, const uint8_t *p, size_t n)
+{
+  uint64_t x;
+
+  while (n && ((uintptr_t) p & 7)) {
+    crc = __crc32cb(crc, *p++);
+    n -= 1;
+  }
+  while (n >= 8) {
+    memcpy(&x, p, 8);
+    crc = __crc32cd(crc, x);
+    p += 8;
+    n -= 8;
+  }
+  while (n) {
+    crc = __crc32cb(crc, *p++);
+    n -= 1;
+  }
+  return crc;
+}
+
+static int crc32c_have_hardware(void)
+{
+  return 1;
+}
+#endif
+
+static void crc32c_init(void)
+{
+  uint32_t i, j, crc;
+
+  for (i = 0; i < 256; ++i) {
+    crc = i;
+    for (j = 0; j < 8; ++j) {
+      crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+    }
+    crc32c_table[0][i] = crc;
+  }
+  for (i = 0; i < 256; ++i) {
+    for (j = 1; j < 8; ++j) {
+      crc32c_table[j][i] = crc32c_table[0][crc32c_table[j - 1][i] & 0xff] ^ (crc32c_table[j - 1][i] >> 8);
+    }
+  }
+
+  crc32c_function = crc32c_soft;
+#ifdef CRC32C_HARDWARE
+  if (crc32c_have_hardware()) crc32c_function = crc32c_hardware;
+#endif
+}
+
+extern uint32_t crc32c_update(uint32_t crc, const void *data, size_t length)
+{
+  pthread_once(&crc32c_once, crc32c_init);
+  return ~crc32c_function(~crc, data, length);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Update the CRC32C (Castagnoli) `crc` with `length` bytes of data.
+ * Start with a crc of 0. Uses the CRC32 instructions of the CPU if available. */
+extern uint32_t crc32c_update(uint32_t crc, const void *data, size_t length);
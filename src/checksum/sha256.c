@@ -0,0 +1,160 @@
+#include "sha256.h"
+
+#include <string.h>
+
+static const uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n) ((x) >> (n) | (x) << (32 - (n)))
+
+static void sha256_block_soft(uint32_t *s, const uint8_t *p)
+{
+  uint32_t w[64], a, b, c, d, e, f, g, h, t1, t2;
+  int i;
+
+  for (i = 0; i < 16; ++i) {
+    w[i] = (uint32_t) p[4 * i] << 24 | p[4 * i + 1] << 16 | p[4 * i + 2] << 8 | p[4 * i + 3];
+  }
+  for (i = 16; i < 64; ++i) {
+    w[i] = w[i - 16] + (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+      w[i - 7] + (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+  }
+
+  a = s[0]; b = s[1]; c = s[2]; d = s[3];
+  e = s[4]; f = s[5]; g = s[6]; h = s[7];
+  for (i = 0; i < 64; ++i) {
+    t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+    t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+  s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+/* SHA-256 with the SHA extensions of newer x86 CPUs.
+ * The state is kept as ABEF and CDGH as the instructions expect it. */
+__attribute__((target("sha,sse4.1")))
+static void sha256_blocks_hardware(uint32_t *s, const uint8_t *p, size_t count)
+{
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i state0, state1, abef, cdgh, msg, tmp, w[4];
+  int g;
+
+  tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &s[0]), 0xb1);
+  state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &s[4]), 0x1b);
+  state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+  while (count--) {
+    abef = state0;
+    cdgh = state1;
+    for (g = 0; g < 16; ++g) {
+      if (g < 4) w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (p + 16 * g)), mask);
+      msg = _mm_add_epi32(w[g % 4], _mm_loadu_si128((const __m128i *) &sha256_k[4 * g]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      if (g >= 3 && g <= 14) {
+        tmp = _mm_alignr_epi8(w[g % 4], w[(g + 3) % 4], 4);
+        w[(g + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(w[(g + 1) % 4], tmp), w[g % 4]);
+      }
+      state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e));
+      if (g >= 1 && g <= 12) w[(g + 3) % 4] = _mm_sha256msg1_epu32(w[(g + 3) % 4], w[g % 4]);
+    }
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+    p += 64;
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1b);
+  state1 = _mm_shuffle_epi32(state1, 0xb1);
+  _mm_storeu_si128((__m128i *) &s[0], _mm_blend_epi16(tmp, state1, 0xf0));
+  _mm_storeu_si128((__m128i *) &s[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+static int sha256_have_hardware(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+}
+#define SHA256_HARDWARE
+#endif
+
+static void sha256_blocks(uint32_t *s, const uint8_t *p, size_t count)
+{
+#ifdef SHA256_HARDWARE
+  static int hardware = -1;
+  if (hardware < 0) hardware = sha256_have_hardware();
+  if (hardware) {
+    sha256_blocks_hardware(s, p, count);
+    return;
+  }
+#endif
+  while (count--) {
+    sha256_block_soft(s, p);
+    p += 64;
+  }
+}
+
+extern void sha256_init(sha256_context *c)
+{
+  static const uint32_t h[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+  memcpy(c->state, h, sizeof(h));
+  c->length = 0;
+}
+
+extern void sha256_update(sha256_context *c, const void *data, size_t length)
+{
+  const uint8_t *p = data;
+  size_t used = c->length % 64, n;
+
+  c->length += length;
+  if (used) {
+    n = 64 - used < length ? 64 - used : length;
+    memcpy(c->buffer + used, p, n);
+    p += n;
+    length -= n;
+    if (used + n < 64) return;
+    sha256_blocks(c->state, c->buffer, 1);
+  }
+  sha256_blocks(c->state, p, length / 64);
+  p += length / 64 * 64;
+  memcpy(c->buffer, p, length % 64);
+}
+
+extern void sha256_final(sha256_context *c, uint8_t digest[32])
+{
+  uint64_t bits = c->length * 8;
+  size_t used = c->length % 64;
+  int i;
+
+  c->buffer[used++] = 0x80;
+  if (used > 56) {
+    memset(c->buffer + used, 0, 64 - used);
+    sha256_blocks(c->state, c->buffer, 1);
+    used = 0;
+  }
+  memset(c->buffer + used, 0, 56 - used);
+  for (i = 0; i < 8; ++i) {
+    c->buffer[56 + i] = bits >> (56 - 8 * i);
+  }
+  sha256_blocks(c->state, c->buffer, 1);
+  for (i = 0; i < 8; ++i) {
+    digest[4 * i] = c->state[i] >> 24;
+    digest[4 * i + 1] = c->state[i] >> 16;
+    digest[4 * i + 2] = c->state[i] >> 8;
+    digest[4 * i + 3] = c->state[i];
+  }
+}
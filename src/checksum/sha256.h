@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t state[8];
+  uint64_t length;
+  uint8_t buffer[64];
+} sha256_context;
+
+/* Start a new SHA-256 hash. */
+extern void sha256_init(sha256_context *c);
+
+/* Add `length` bytes of data to the hash. */
+extern void sha256_update(sha256_context *c, const void *data, size_t length);
+
+/* Finish the hash and store the 32 byte digest. */
+extern void sha256_final(sha256_context *c, uint8_t digest[32]);
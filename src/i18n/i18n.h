@@ -4,6 +4,7 @@
 #define I18N_HEADER
 typedef struct {
   const char *comment_too_long;
+  const char *could_not_copy_ss;
   const char *could_not_create_file_ss;
   const char *could_not_open_logfile_s;
   const char *could_not_open_ss;
@@ -16,11 +17,21 @@ typedef struct {
   const char *errno_einval;
   const char *errno_enoent;
   const char *gain;
+  const char *index_needs_path;
+  const char *index_needs_seek;
+  const char *invalid_bandwidth;
   const char *invalid_channel_names;
+  const char *invalid_chunk_size;
   const char *invalid_cut;
+  const char *invalid_encoding;
   const char *invalid_end_time;
+  const char *invalid_manifest_s;
+  const char *invalid_queue_depth;
+  const char *invalid_record_length;
   const char *invalid_start_time;
   const char *invalid_station_code;
+  const char *invalid_threads;
+  const char *invalid_write_buffer;
   const char *io_error;
   const char *io_error_d;
   const char *label_6d6_sn;
@@ -42,6 +53,7 @@ typedef struct {
   const char *need_name_for_every_channel;
   const char *out_of_memory;
   const char *processing_s;
+  const char *resuming_at_f;
   const char *skew_ignored_warning;
   const char *too_many_channel_names;
   const char *unexpected_argument_s;
@@ -52,6 +64,8 @@ typedef struct {
   const char *usage_6d6mseed_s;
   const char *usage_6d6read_s;
   const char *using_channel_mapping;
+  const char *verify_failed_s;
+  const char *verify_ok_s;
   const char *version_ss;
 } I18n;
 extern const I18n *en_GB;
@@ -79,6 +93,7 @@ static inline void i18n_set_lang(const char *lang)
 #undef I18N_IMPLEMENTATION
 static I18n _en_GB = {
   .comment_too_long = "The comment is too long to fit into the header.\n",
+  .could_not_copy_ss = "Could not copy '%s' to '%s'.\n",
   .could_not_create_file_ss = "Could not create file '%s': %s.\n",
   .could_not_open_logfile_s = "Could not open logfile: %s.\n",
   .could_not_open_ss = "Could not open '%s': %s.\n",
@@ -91,11 +106,21 @@ static I18n _en_GB = {
   .errno_einval = "Invalid argument",
   .errno_enoent = "No such file or directory",
   .gain = "Gain",
+  .index_needs_path = "There is no place for an index next to this input. Give its path with '--index-file'.\n",
+  .index_needs_seek = "The option '--index' needs an input which can seek.\n",
+  .invalid_bandwidth = "Invalid value for '--bandwidth'. It must be a number of bytes per second like '40M'.\n",
   .invalid_channel_names = "Channel names must be between 1 and 3 alphanumeric characters.\n",
+  .invalid_chunk_size = "Invalid value for '--chunk-size'. It must be a multiple of 512 bytes up to 256M.\n",
   .invalid_cut = "Invalid value for '--cut'.\n",
+  .invalid_encoding = "Invalid value for '--encoding'. It must be 'int32', 'steim1' or 'steim2'.\n",
   .invalid_end_time = "Invalid value for '--end-time'.\n",
+  .invalid_manifest_s = "Invalid manifest '%s'.\n",
+  .invalid_queue_depth = "Invalid value for '--queue-depth'. It must be between 1 and 64.\n",
+  .invalid_record_length = "Invalid value for '--record-length'. It must be a power of two from 256 to 65536.\n",
   .invalid_start_time = "Invalid value for '--start-time'.\n",
   .invalid_station_code = "Please specify a station code of 1 to 5 alphanumeric characters with --station=CODE.\n",
+  .invalid_threads = "Invalid value for '--threads'. It must be between 1 and 256.\n",
+  .invalid_write_buffer = "Invalid value for '--write-buffer'. It must be a multiple of 64k up to 256M.\n",
   .io_error = "I/O error!\n",
   .io_error_d = "I/O error (%d)!\n",
   .label_6d6_sn = "    6D6 S/N:",
@@ -117,21 +142,25 @@ static I18n _en_GB = {
   .need_name_for_every_channel = "When specifying channel names, you must give a name for every channel.\n",
   .out_of_memory = "Out of memory!\n",
   .processing_s = "Processing '%s'.\n",
+  .resuming_at_f = "Resuming the copy at %.1f MB.\n",
   .skew_ignored_warning = "Warning: You have chosen to deactivate the skew correction.\nThis is almost certainly a bad idea unless you know exactly what you want\nto achieve.\n",
   .too_many_channel_names = "Too many channel names.\n",
   .unexpected_argument_s = "Option '--%s' expects no argument.\n",
   .unrecognised_long_s = "Unrecognised option '--%s'.\n",
   .unrecognised_short_c = "Unrecognised option '-%c'.\n",
-  .usage_6d6copy_s = "6d6copy\n=======\n\nThe program '6d6copy' makes a perfect copy of a StiK or 6D6 SD card\nto a file.\nThis is a great backup mechanism and you can use the .6d6 files as a\nstarting point for arbitrary data analysis methods.\n\nUsage\n-----\n\n  %s [options] /dev/sdX1 out.6d6\n\nThe first argument is the source of the data. This is normally your\nStiK or SD card device like '/dev/sdb1' or '/dev/mmcblk0p1'.\nThe second argument is the file to which the copy will be made.\nThis file should have a .6d6 ending to identify it as 6D6 raw data.\n\nWhen you start the program and the input and output files are valid,\nthe copy operation begins and the progress is shown on the terminal.\nTo suppress that progress display you can use the flags '-q' or\n'--no-progress'. This might be useful in automated scripts.\n\nOptions\n-------\n\n--append-comment=TEXT\n\n  Append the given text to the comment header. If the text contains a backslash\n  it escapes the next character. You can write \\n to insert a newline and \\\\ to\n  insert a literal backslash.\n\n-q\n--no-progress\n\n  Suppresses the progress display.\n\n--json-progress\n\n  Output progress in form of JSON messages. Each message is on one line.\n  This makes the progress output got to STDOUT instead of STDERR.\n\nExamples\n--------\n\nArchive the StiK in '/dev/sdb1' to a backup hard drive.\n\n  $ 6d6copy /dev/sdb1 /media/Backup/Experiment-003/Station-007.6d6\n\nCopy the SD card in '/dev/mmcblk0p1' to the current directory.\n\n  $ 6d6copy /dev/mmcblk0p1 Station-013.6d6\n\n",
-  .usage_6d6info_s = "6d6info\n=======\n\nThe program '6d6info' shows some information about a 6D6 recording.\nYou can either use it on a StiK or SD card or to get some information\nabout a .6d6 file on your hard drive.\n\nUsage\n-----\n\n  %s [options] /dev/sdX1\n\nThe parameter is the file or device you want to inspect.\n\nOptions\n-------\n\n--json\n\n  Output JSON instead of formatted text.\n\nExamples\n--------\n\nInspect the StiK in '/dev/sdb1':\n\n  $ 6d6info /dev/sdb1\n\nInspect the file 'station-007.6d6' in the directory 'line-001':\n\n  $ 6d6info line-001/station-007.6d6\n\n",
-  .usage_6d6mseed_s = "6d6mseed\n========\n\nThe program '6d6mseed' is used to convert raw data from the 6D6 datalogger\ninto the MiniSEED format.\n\nUsage\n-----\n\n  %s [options] input.6d6\n\nOptions\n-------\n\n--station=CODE\n\n  Set the MiniSEED station code to CODE. The station code is required for\n  MiniSEED generation. It can contain between one and five alphanumeric\n  ASCII characters.\n\n--location=CODE\n\n  Set the location to CODE. This should usually be a two character code.\n\n--network=CODE\n\n  Set the network code to CODE. This is a two character code assigned by IRIS.\n\n--channels=C1,C2,...\n\n  Rename the channels. When using this option, you have to give a new name for\n  every channel which is between 1 and 3 alphanumeric characters. The names\n  must be seperated by commas without spaces.\n\n--output=FILENAME_TEMPLATE\n\n  Set a template for output files. The template string may contain the following\n  placeholders:\n\n    %%y - Year\n    %%m - Month\n    %%d - Day\n    %%h - Hour\n    %%i - Minute\n    %%s - Second\n    %%S - Station Code\n    %%L - Location\n    %%C - Channel\n    %%N - Network\n\n  The default value is 'out/%%S/%%y-%%m-%%d-%%C.mseed'.\n\n--cut=SECONDS\n\n  Cut the data in files of SECONDS. The default value is 86400, i.e. one day.\n\n--no-cut\n\n  Do not cut the MiniSEED files and produce one big file per channel.\n\n--start-time=TIME\n--end-time=TIME\n\n  Limit the conversion to the time between start and end.\n  If these options are used, the resulting MiniSEED files will not include any\n  samples before the given start time and no samples after the given end time.\n\n  The default values are the beginning and ending of the recording.\n\n  The times must be given as ISO string, i.e. 'YYYY-MM-DDTHH:MM:SSZ'.\n\n--logfile=FILE\n\n  Create a logfile at FILE.\n  The logfile contains all important information regarding recording data\n  and created files. It also lists errors which occured during processing.\n\n--auxfile=FILE\n\n  Create a CSV file with auxiliary data at FILE.\n  The auxfile contains engineering data like the temperature and battery\n  voltage.\n\n--ignore-skew\n\n  Do not use the second synchronisation. This will on average double the timing\n  error and thus will always print a warning and should not be used.\n\n--resample\n\n  Do skew correction by resampling the data to the nominal sampling frequency.\n\nExamples\n--------\n\nConvert the file 'ST007.6d6' to MiniSEED using default values.\n\n  $ 6d6mseed --station=ST007 ST007.6d6\n\nConvert the file 'ST007.6d6' specifying everything.\n\n  $ 6d6mseed ST007.6d6 \\\n      --station=ST007 \\\n      --network=XX \\\n      --output=%%N/%%S/%%y-%%m-%%d-%%C.mseed\n\n",
-  .usage_6d6read_s = "6d6read\n=======\n\nThe program '6d6read' is used to convert raw data from the 6D6 datalogger\ninto the Send2X format.\nThis is useful if you still have a lot of old dataloggers and want to use\na uniform method of data analysis.\n\nUsage\n-----\n\n  %s [-q|--no-progress] < in.6d6 > out.s2x\n\nThe input file is a .6d6 file and is written with an opening angle bracket '<'.\nThe output file will be a .s2x file and is preceded by a closing angle\nbracket '>'.\n\nIf the input file is a valid .6d6 file, the conversion process will begin and\nthe progress will be reported to the terminal. If you want to suppress the\nprogress display, you can use the flag '-q' or '--no-progress'. This might be\nuseful in automated scripts.\n\nExamples\n--------\n\nConvert the file 'station-007.6d6' to Send2X format:\n\n  $ 6d6read < station-007.6d6 > station-007.s2x\n\nConvert the file 'x.6d6' to 'y.s2x' and suppress the progress display:\n\n  $ 6d6read --no-progress < x.6d6 > y.s2x\n",
+  .usage_6d6copy_s = "6d6copy\n=======\n\nThe program '6d6copy' makes a perfect copy of a StiK or 6D6 SD card\nto a file.\nThis is a great backup mechanism and you can use the .6d6 files as a\nstarting point for arbitrary data analysis methods.\n\nUsage\n-----\n\n  %s [options] /dev/sdX1 out.6d6 [/dev/sdY1 out2.6d6 ...]\n  %s --verify out.6d6\n\nThe first argument is the source of the data. This is normally your\nStiK or SD card device like '/dev/sdb1' or '/dev/mmcblk0p1'.\nThe second argument is the file to which the copy will be made.\nThis file should have a .6d6 ending to identify it as 6D6 raw data.\n\nSeveral StiKs or SD cards can be copied at once by giving more pairs of\nsource and destination. Each card is copied by its own process, but only\none card at a time is read from each device.\n\nWhen you start the program and the input and output files are valid,\nthe copy operation begins and the progress is shown on the terminal.\nTo suppress that progress display you can use the flags '-q' or\n'--no-progress'. This might be useful in automated scripts.\n\nOptions\n-------\n\n--append-comment=TEXT\n\n  Append the given text to the comment header. If the text contains a backslash\n  it escapes the next character. You can write \\n to insert a newline and \\\\ to\n  insert a literal backslash.\n\n-q\n--no-progress\n\n  Suppresses the progress display.\n\n--json-progress\n\n  Output progress in form of JSON messages. Each message is on one line.\n  This makes the progress output got to STDOUT instead of STDERR.\n  When several cards are copied, each message also contains the list 'copies'\n  with the progress of every copy in the order of the arguments.\n\n--direct\n\n  Read the StiK or SD card with direct I/O, bypassing the page cache of the\n  operating system. Several reads are kept in flight to keep the card busy.\n  If the device does not support direct I/O, it is read normally.\n  Without this option the data is copied by the operating system itself,\n  which on file systems like XFS or Btrfs can share the data with the input.\n\n--queue-depth=N\n\n  Keep up to N reads in flight at once. Card readers and USB3 enclosures often\n  need several outstanding reads to reach their full speed.\n  The default value is 4.\n\n--chunk-size=SIZE\n\n  Read the StiK or SD card in chunks of SIZE bytes. The size must be a multiple\n  of 512 and may be given with a suffix like '512k' or '8M'.\n  The default value is 4M.\n\n--checksum\n\n  Compute a CRC32C checksum of the copy while it is written and store it in\n  the manifest 'out.6d6.manifest' next to the copy.\n\n--sha256\n\n  Like '--checksum', but also compute a SHA-256 hash.\n\n--verify\n\n  Read the copy given as the only argument again and compare it against its\n  manifest. The exit status is 0 if the copy matches.\n\n--resume\n\n  Write checkpoints to 'out.6d6.checkpoint' while copying. If the copy was\n  interrupted, running the same command again checks the part which was\n  already copied and continues after the last good checkpoint.\n\n--drop-cache\n\n  Remove the copy from the page cache of the operating system as soon as it is\n  on the disk. This keeps the cache free for other programs when many StiKs or\n  SD cards are copied one after another.\n\n--bandwidth=RATE\n\n  Copy at most RATE bytes per second, counting all copies together. The rate\n  may be given with a suffix like '40M'.\n\nExamples\n--------\n\nArchive the StiK in '/dev/sdb1' to a backup hard drive.\n\n  $ 6d6copy /dev/sdb1 /media/Backup/Experiment-003/Station-007.6d6\n\nCopy the SD card in '/dev/mmcblk0p1' to the current directory.\n\n  $ 6d6copy /dev/mmcblk0p1 Station-013.6d6\n\nArchive a StiK with a SHA-256 hash and check the archived copy later.\n\n  $ 6d6copy --sha256 /dev/sdb1 Station-007.6d6\n  $ 6d6copy --verify Station-007.6d6\n\nCopy a large StiK in a way that can be continued after an interruption.\n\n  $ 6d6copy --resume /dev/sdb1 Station-007.6d6\n\nCopy three StiKs at once.\n\n  $ 6d6copy /dev/sdb1 Station-007.6d6 /dev/sdc1 Station-008.6d6 /dev/sdd1 Station-009.6d6\n\n",
+  .usage_6d6info_s = "6d6info\n=======\n\nThe program '6d6info' shows some information about a 6D6 recording.\nYou can either use it on a StiK or SD card or to get some information\nabout a .6d6 file on your hard drive.\n\nUsage\n-----\n\n  %s [options] /dev/sdX1\n\nThe parameter is the file or device you want to inspect.\n\nOptions\n-------\n\n--json\n\n  Output JSON instead of formatted text.\n\n--scan\n\n  Read through the whole recording instead of showing the headers. The\n  control frames are collected and the sample frames are skipped, which is\n  much faster than a conversion. Prints a JSON summary with the number of\n  sample and time frames, the times of the first and last time frame, the\n  time of the last sample, the number of lost frames and reboots, whether\n  the recording has an end frame, and the range of the temperature,\n  humidity and battery voltage.\n\n--auxfile=FILE\n\n  With --scan, also create a CSV file with auxiliary data at FILE, the same\n  as the one from 6d6mseed.\n\nExamples\n--------\n\nInspect the StiK in '/dev/sdb1':\n\n  $ 6d6info /dev/sdb1\n\nInspect the file 'station-007.6d6' in the directory 'line-001':\n\n  $ 6d6info line-001/station-007.6d6\n\nGet the real end time and the temperature history of the same file:\n\n  $ 6d6info --scan --auxfile=station-007.csv line-001/station-007.6d6\n\n",
+  .usage_6d6mseed_s = "6d6mseed\n========\n\nThe program '6d6mseed' is used to convert raw data from the 6D6 datalogger\ninto the MiniSEED format.\n\nUsage\n-----\n\n  %s [options] input.6d6\n\nOptions\n-------\n\n--station=CODE\n\n  Set the MiniSEED station code to CODE. The station code is required for\n  MiniSEED generation. It can contain between one and five alphanumeric\n  ASCII characters.\n\n--location=CODE\n\n  Set the location to CODE. This should usually be a two character code.\n\n--network=CODE\n\n  Set the network code to CODE. This is a two character code assigned by IRIS.\n\n--channels=C1,C2,...\n\n  Rename the channels. When using this option, you have to give a new name for\n  every channel which is between 1 and 3 alphanumeric characters. The names\n  must be seperated by commas without spaces.\n\n--output=FILENAME_TEMPLATE\n\n  Set a template for output files. The template string may contain the following\n  placeholders:\n\n    %%y - Year\n    %%m - Month\n    %%d - Day\n    %%h - Hour\n    %%i - Minute\n    %%s - Second\n    %%S - Station Code\n    %%L - Location\n    %%C - Channel\n    %%N - Network\n\n  The default value is 'out/%%S/%%y-%%m-%%d-%%C.mseed'.\n\n--cut=SECONDS\n\n  Cut the data in files of SECONDS. The default value is 86400, i.e. one day.\n\n--no-cut\n\n  Do not cut the MiniSEED files and produce one big file per channel.\n\n--start-time=TIME\n--end-time=TIME\n\n  Limit the conversion to the time between start and end.\n  If these options are used, the resulting MiniSEED files will not include any\n  samples before the given start time and no samples after the given end time.\n  Reading stops once every channel has passed the end time, so the auxfile\n  ends there as well.\n\n  The default values are the beginning and ending of the recording.\n\n  The times must be given as ISO string, i.e. 'YYYY-MM-DDTHH:MM:SSZ'.\n\n--index\n\n  Build an index of the time frames next to the input file, e.g.\n  'ST007.6d6idx' for 'ST007.6d6', if there is none yet or if it belongs to\n  another recording. With an index, '--start-time' seeks directly to the start\n  instead of decoding everything before it. An existing index is used even\n  without this option. Without an index, the start is found by bisecting the\n  recording.\n\n--index-file=FILE\n\n  Use FILE as the index instead of the file next to the input. This is needed\n  to build an index for a StiK or SD card.\n\n--logfile=FILE\n\n  Create a logfile at FILE.\n  The logfile contains all important information regarding recording data\n  and created files. It also lists errors which occured during processing.\n\n--auxfile=FILE\n\n  Create a CSV file with auxiliary data at FILE.\n  The auxfile contains engineering data like the temperature and battery\n  voltage.\n\n--ignore-skew\n\n  Do not use the second synchronisation. This will on average double the timing\n  error and thus will always print a warning and should not be used.\n\n--encoding=NAME\n\n  Set the encoding of the samples in the MiniSEED records. 'int32' stores\n  every sample in 32 bits, which is the default. 'steim1' stores the\n  differences between the samples in 8, 16 or 32 bits, which makes the files\n  about two to three times smaller for most recordings. 'steim2' packs the\n  differences even more densely in 4 to 30 bits. Records which Steim would\n  make larger, like those of very noisy data, are stored as 'int32'.\n\n--record-length=BYTES\n\n  Set the length of the MiniSEED records, a power of two from 256 to 65536\n  bytes. The default is 4096. Short records are useful to forward data with\n  little delay, long records carry less overhead for large archives.\n\n--write-buffer=SIZE\n\n  Collect SIZE bytes of records for each channel before writing them to the\n  file. The size must be a multiple of 64k and may be given with a suffix like\n  '512k' or '8M'. The default value is 4M.\n\n--resample\n\n  Do skew correction by resampling the data to the nominal sampling frequency.\n\n--direct\n\n  Read the input with direct I/O, bypassing the page cache of the operating\n  system. This is useful when reading large recordings from a StiK or SD card.\n  If the device does not support direct I/O, the input is read normally.\n\n--queue-depth=N\n\n  Keep up to N reads from a StiK or SD card in flight at once. Card readers and\n  USB3 enclosures often need several outstanding reads to reach their full\n  speed. The default value is 4.\n\n--chunk-size=SIZE\n\n  Read the input in chunks of SIZE bytes. The size must be a multiple of 512\n  and may be given with a suffix like '512k' or '8M'. The default value is 4M.\n\n--threads=N\n\n  Use N threads. The input is decoded in several parts at the same time and\n  the channels are converted on their own threads, so more threads than\n  channels do not help much. The default value is 1.\n\nExamples\n--------\n\nConvert the file 'ST007.6d6' to MiniSEED using default values.\n\n  $ 6d6mseed --station=ST007 ST007.6d6\n\nConvert the file 'ST007.6d6' specifying everything.\n\n  $ 6d6mseed ST007.6d6 \\\n      --station=ST007 \\\n      --network=XX \\\n      --output=%%N/%%S/%%y-%%m-%%d-%%C.mseed\n\n",
+  .usage_6d6read_s = "6d6read\n=======\n\nThe program '6d6read' is used to convert raw data from the 6D6 datalogger\ninto the Send2X format.\nThis is useful if you still have a lot of old dataloggers and want to use\na uniform method of data analysis.\n\nUsage\n-----\n\n  %s [-q|--no-progress] [--direct] [--queue-depth=N] [--chunk-size=SIZE] < in.6d6 > out.s2x\n\nThe input file is a .6d6 file and is written with an opening angle bracket '<'.\nThe output file will be a .s2x file and is preceded by a closing angle\nbracket '>'.\n\nIf the input file is a valid .6d6 file, the conversion process will begin and\nthe progress will be reported to the terminal. If you want to suppress the\nprogress display, you can use the flag '-q' or '--no-progress'. This might be\nuseful in automated scripts.\n\nWhen reading directly from a StiK or SD card, the flag '--direct' bypasses the\npage cache of the operating system. If the device does not support direct I/O,\nit is read normally. The options '--queue-depth' and '--chunk-size' set the\nnumber of reads in flight (default 4) and their size (default 4M).\n\nThe options '--start-time' and '--end-time' limit the conversion to the given\ntimes. If the input can seek, '--start-time' finds the start by bisecting the\nrecording instead of decoding everything before it. When the input file is\ngiven by name, the flag '--index' builds an index of the time frames next to\nit, e.g. 'x.6d6idx' for 'x.6d6', if there is none yet, which is used instead.\nThe option '--index-file=FILE' stores the index in FILE, which is needed for\nStiKs, SD cards and input from '<'.\n\nExamples\n--------\n\nConvert the file 'station-007.6d6' to Send2X format:\n\n  $ 6d6read < station-007.6d6 > station-007.s2x\n\nConvert the file 'x.6d6' to 'y.s2x' and suppress the progress display:\n\n  $ 6d6read --no-progress < x.6d6 > y.s2x\n",
   .using_channel_mapping = "Using Channel Mapping:\n",
+  .verify_failed_s = "'%s' does NOT match its manifest!\n",
+  .verify_ok_s = "'%s' matches its manifest.\n",
   .version_ss = "6D6 Compatibility Tools Version %s (%s)\n\n",
 };
 const I18n *en_GB = &_en_GB;
 static I18n _de_DE = {
   .comment_too_long = "Der Kommentar passt nicht in den 6D6-Header.\n",
+  .could_not_copy_ss = "Konnte '%s' nicht nach '%s' kopieren.\n",
   .could_not_create_file_ss = "Konnte Datei '%s' nicht erstellen: %s.\n",
   .could_not_open_logfile_s = "Konnte Logdatei nicht öffnen: %s.\n",
   .could_not_open_ss = "Konnte '%s' nicht öffnen: %s.\n",
@@ -144,11 +173,21 @@ static I18n _de_DE = {
   .errno_einval = "Ungültiges Argument",
   .errno_enoent = "Die Datei oder das Verzeichnis existiert nicht",
   .gain = "Gain",
+  .index_needs_path = "Neben dieser Eingabe ist kein Platz für einen Index. Der Pfad kann mit '--index-file' angegeben werden.\n",
+  .index_needs_seek = "Die Option '--index' benötigt eine Eingabe, in der gesprungen werden kann.\n",
+  .invalid_bandwidth = "Ungültiger Wert für '--bandwidth'. Er muss eine Anzahl Bytes pro Sekunde wie '40M' sein.\n",
   .invalid_channel_names = "Kanalnamen müssen aus 1 bis 3 alphanumerischen Zeichen bestehen.\n",
+  .invalid_chunk_size = "Ungültiger Wert für '--chunk-size'. Er muss ein Vielfaches von 512 Bytes bis 256M sein.\n",
   .invalid_cut = "Ungültiger Wert für '--cut'.\n",
+  .invalid_encoding = "Ungültiger Wert für '--encoding'. Er muss 'int32', 'steim1' oder 'steim2' sein.\n",
   .invalid_end_time = "Ungültiger Wert für '--end-time'.\n",
+  .invalid_manifest_s = "Ungültiges Manifest '%s'.\n",
+  .invalid_queue_depth = "Ungültiger Wert für '--queue-depth'. Er muss zwischen 1 und 64 liegen.\n",
+  .invalid_record_length = "Ungültiger Wert für '--record-length'. Er muss eine Zweierpotenz von 256 bis 65536 sein.\n",
   .invalid_start_time = "Ungültiger Wert für '--start-time'.\n",
   .invalid_station_code = "Bitte geben Sie einen Stationscode von 1 bis 5 alphanumerischen Zeichen mit\n--station=CODE an.\n",
+  .invalid_threads = "Ungültiger Wert für '--threads'. Er muss zwischen 1 und 256 liegen.\n",
+  .invalid_write_buffer = "Ungültiger Wert für '--write-buffer'. Er muss ein Vielfaches von 64k bis 256M sein.\n",
   .io_error = "I/O-Fehler!\n",
   .io_error_d = "I/O-Fehler (%d)!\n",
   .label_6d6_sn = "    6D6 S/N:",
@@ -170,16 +209,19 @@ static I18n _de_DE = {
   .need_name_for_every_channel = "Es muss für jeden Kanal ein Name angegeben werden.\n",
   .out_of_memory = "Arbeitsspeicher ist voll!\n",
   .processing_s = "Verarbeite '%s'.\n",
+  .resuming_at_f = "Die Kopie wird bei %.1f MB fortgesetzt.\n",
   .skew_ignored_warning = "Warnung: Die Skew-Korrektur ist ausgeschaltet.\nDies ist in fast allen Fällen eine schlechte Idee und sollte nur verwendet\nwerden, wenn man genau weiß, was man erreichen möchte.\n",
   .too_many_channel_names = "Zu viele Kanalnamen angegeben.\n",
   .unexpected_argument_s = "Die Option '--%s' benötigt kein Argument.\n",
   .unrecognised_long_s = "Unbekannte Option '--%s'.\n",
   .unrecognised_short_c = "Unbekannte Option '-%c'.\n",
-  .usage_6d6copy_s = "6d6copy\n=======\n\nDas Programm '6d6copy' erstellt eine 1:1-Kopie eines StiKs oder einer SD-Karte\nin eine .6d6-Datei.\nEine .6d6-Datei ist besonders für Backups geeignet, da sie alle Rohdaten in\nunveränderter Form enthält. Sie ist somit auch prädestinierter Startpunkt für\nbeliebige Datenanalysen und Konvertierungen.\n\nVerwendung\n----------\n\n  %s [Optionen] /dev/sdX1 out.6d6\n\nDer erste Parameter ist die Quelldatei. Dies ist normalerweise der Gerätepfad\ndes StiKs oder der SD-Karte und sieht ähnlich aus wie '/dev/sdb1' oder\n'/dev/mmcblk0p1'.\nDer zweite Parameter ist der Dateiname, unter dem die Kopie gespeichert werden\nsoll. Diese Datei sollte am besten die Endung '.6d6' haben, um sie als\n6D6-Rohdaten-Datei zu identifizieren.\n\nWenn Eingabe- und Ausgabedatei gültig sind, beginnt der Kopiervorgang und der\nFortschritt wird im Terminal angezeigt. Um die Ausgabe z.B. für automatisierte\nScripts zu unterdrücken, kann die Option '-q' bzw. '--no-progress' verwendet\nwerden.\n\nOptionen\n--------\n\n--append-comment=TEXT\n\n  Hängt den angegebenen Text an den Kommentar-Header an. Wenn der Text\n  Backslashes enthält, wird das nächste Zeichen speziell behandelt.\n  Man kann \\n schreiben, um einen Zeilenumbruch zu erzeugen und \\\\ für einen\n  Backslash.\n\n-q\n--no-progress\n\n  Unterdrückt die Fortschrittsanzeige.\n\n--json-progress\n\n  Die Fortschrittsanzeige erfolt in Form von JSON-Nachrichten. Jede Nachricht\n  wird durch einen Zeilenumbruch abgeschlossen. Die Ausgabe erfolgt nach STDOUT\n  statt nach STDERR.\n\nBeispiele\n---------\n\nArchiviert den StiK in '/dev/sdb1' auf eine Backup-Festplatte.\n\n  $ 6d6copy /dev/sdb1 /media/Backup/Experiment-003/Station-007.6d6\n\nKopiert die SD-Karte in '/dev/mmcblk0p1' ins aktuelle Verzeichnis.\n\n  $ 6d6copy /dev/mmcblk0p1 Station-013.6d6\n\n",
-  .usage_6d6info_s = "6d6info\n=======\n\nDas Programm '6d6info' zeigt Informationen zu einer 6D6-Aufnahme an.\nEs kann entweder direkt mit einem StiK oder einer SD-Karte verwendet werden oder\nInformationen über eine .6d6-Datei auf der Festplatte anzeigen.\n\nVerwendung\n----------\n\n  %s [Optionen] /dev/sdX1\n\nDer Parameter ist die Datei oder das Gerät, das untersucht werden soll.\n\nOptionen\n--------\n\n--json\n\n  Gibt JSON statt formatiertem Text aus.\n\nBeispiele\n---------\n\nZeigt Informationen zum StiK in '/dev/sdb1':\n\n  $ 6d6info /dev/sdb1\n\nZeigt Informationen zur Datei 'station-007.6d6' im Ordner 'line-001':\n\n  $ 6d6info line-001/station-007.6d6\n\n",
-  .usage_6d6mseed_s = "6d6mseed\n========\n\nDas Programm '6d6mseed' konvertiert Rohdaten des 6D6-Datenloggers in das\nMiniSEED-Format.\n\nVerwendung\n----------\n\n  %s [Optionen] input.6d6\n\nOptionen\n--------\n\n--station=CODE\n\n  Setzt den MiniSEED-Stationscode auf CODE. Der Stationscode ist für die\n  MiniSEED-Erzeugung zwingend erforderlich. Er besteht aus 1 bis 5 alpha-\n  numerischen ASCII-Zeichen.\n\n--location=CODE\n\n  Setzt den Location-Code auf CODE. Der Location-Code besteht aus zwei Zeichen\n  und kann benutzt werden um mehrere Sensoren an einer Station zu unterscheiden.\n\n--network=CODE\n\n  Setzt den Network-Code auf CODE. Dies ist ein zweistelliger Code, der vom\n  IRIS vergeben wird.\n\n--channels=C1,C2,...\n\n  Benutzt abweichende Kanalnamen. Die Namen müssen aus 1 bis 3 alphanumerischen\n  Zeichen bestehen und werden durch Kommata ohne Leerzeichen getrennt.\n  Wenn diese Option benutzt wird, muss für jeden Kanal ein Name festgelegt\n  werden.\n\n--output=FILENAME_TEMPLATE\n\n  Setzt ein Muster für Dateinamen. Im Muster können die folgenden Platzhalter\n  verwendet werden:\n\n    %%y - Jahr\n    %%m - Monat\n    %%d - Tag\n    %%h - Stunde\n    %%i - Minute\n    %%s - Sekunde\n    %%S - Stations-Code\n    %%L - Location-Code\n    %%C - Kanal\n    %%N - Network-Code\n\n  Der Standardwert ist 'out/%%S/%%y-%%m-%%d-%%C.mseed'.\n\n--cut=SECONDS\n\n  Schneidet die Daten in Stücke von SECONDS Sekunden. Der Standardwert ist\n  86400, also ein Tag.\n\n--no-cut\n\n  Schaltet das Schneiden der MiniSEED-Dateien ab und erzeugt stattdessen eine\n  große Datei pro Kanal.\n\n--start-time=TIME\n--end-time=TIME\n\n  Begrenzt die konvertierung auf den angegebenen Zeitraum.\n  Wenn diese Optionen benutzt werden, enthalten die erzeugten MiniSEED-Dateien\n  keine Samples vor der angegebenen Startzeit oder nach der angegebenen Endzeit.\n\n  Die Standardwerte sind der Anfang und das Ende der Aufzeichnung.\n\n  Die Zeiten müssen als ISO-String angegeben werden, das heißt im Format\n  'YYYY-MM-DDTHH:MM:SSZ'.\n\n--logfile=FILE\n\n  Erstellt eine Logdatei unter FILE.\n  Die Logdatei enthält alle wichtigen Ereignisse, die während des Konvertierens\n  auftreten. Das sind hauptsächlich allgemeine Informationen über die Daten,\n  Namen von erstellten Dateien und eventuelle Fehler.\n\n--auxfile=FILE\n\n  Erstellt eine CSV-Datei mit zusätzlichen Daten unter FILE.\n  Die CSV-Datei enthält die Statusdaten des Datenloggers, wie z.B. Temperatur\n  oder Batteriespannung.\n\n--ignore-skew\n\n  Die zweite Synchronisierung wird nicht verwendet. Der Zeitfehler wird\n  hierdurch im Mittel verdoppelt, daher gibt diese Option immer eine Warnung aus\n  und sollte nicht verwendet werden.\n\n--resample\n\n  Die Skew-Korrektur wird durchgeführt, indem die Daten auf die nominelle Samplerate\n  resampled werden.\n\nBeispiele\n---------\n\nKonvertiert die Datei 'ST007.6d6' mit den Standardeinstellungen nach MiniSEED.\nDie Option '--station' wird immer benötigt!\n\n  $ 6d6mseed --station=ST007 ST007.6d6\n\nKonvertiert die Datei 'ST007.6d6' mit einem Network-Code und benutzerdefinierten\nMiniSEED-Dateinamen.\n\n  $ 6d6mseed ST007.6d6 \\\n      --station=ST007 \\\n      --network=XX \\\n      --output=%%N/%%S/%%y-%%m-%%d-%%C.mseed\n\n",
-  .usage_6d6read_s = "6d6read\n=======\n\nDas Programm '6d6read' konvertiert Rohdaten vom 6D6-Datenlogger in das\nSend2X-Format.\nDies kann nützlich sein, wenn noch eine große Anzahl von alten Datenloggern\nvorhanden ist und eine einheitliche Datenverarbeitung gewünscht ist.\n\nVerwendung\n----------\n\n  %s [-q|--no-progress] < in.6d6 > out.s2x\n\nDie Eingabedatei ist eine .6d6-Datei und wird mit einer öffnenden spitzen\nKlammer angegeben '<'.\nDie Ausgabedatei ist eine .s2x-Datei und wird mit einer schließenden spitzen\nKlammer angegeben '>'.\n\nWenn Eingabedatei eine gültige .6d6-Datei ist, beginnt der Konvertierungs-\nvorgang und der Fortschritt wird im Terminal angezeigt. Um die Ausgabe z.B. für\nautomatisierte Scripts zu unterdrücken, kann die Option '-q' bzw.\n'--no-progress' verwendet werden.\n\nBeispiele\n---------\n\nKonvertiert die Datei 'station-007.6d6' ins Send2X-Format:\n\n  $ 6d6read < station-007.6d6 > station-007.s2x\n\nKonvertiert die Datei 'x.6d6' nach 'y.s2x' ohne Fortschrittsanzeige:\n\n  $ 6d6read --no-progress < x.6d6 > y.s2x\n",
+  .usage_6d6copy_s = "6d6copy\n=======\n\nDas Programm '6d6copy' erstellt eine 1:1-Kopie eines StiKs oder einer SD-Karte\nin eine .6d6-Datei.\nEine .6d6-Datei ist besonders für Backups geeignet, da sie alle Rohdaten in\nunveränderter Form enthält. Sie ist somit auch prädestinierter Startpunkt für\nbeliebige Datenanalysen und Konvertierungen.\n\nVerwendung\n----------\n\n  %s [Optionen] /dev/sdX1 out.6d6 [/dev/sdY1 out2.6d6 ...]\n  %s --verify out.6d6\n\nDer erste Parameter ist die Quelldatei. Dies ist normalerweise der Gerätepfad\ndes StiKs oder der SD-Karte und sieht ähnlich aus wie '/dev/sdb1' oder\n'/dev/mmcblk0p1'.\nDer zweite Parameter ist der Dateiname, unter dem die Kopie gespeichert werden\nsoll. Diese Datei sollte am besten die Endung '.6d6' haben, um sie als\n6D6-Rohdaten-Datei zu identifizieren.\n\nMehrere StiKs oder SD-Karten können gleichzeitig kopiert werden, indem weitere\nPaare aus Quelle und Ziel angegeben werden. Jede Karte wird von einem eigenen\nProzess kopiert, aber von jedem Gerät wird nur eine Karte gleichzeitig gelesen.\n\nWenn Eingabe- und Ausgabedatei gültig sind, beginnt der Kopiervorgang und der\nFortschritt wird im Terminal angezeigt. Um die Ausgabe z.B. für automatisierte\nScripts zu unterdrücken, kann die Option '-q' bzw. '--no-progress' verwendet\nwerden.\n\nOptionen\n--------\n\n--append-comment=TEXT\n\n  Hängt den angegebenen Text an den Kommentar-Header an. Wenn der Text\n  Backslashes enthält, wird das nächste Zeichen speziell behandelt.\n  Man kann \\n schreiben, um einen Zeilenumbruch zu erzeugen und \\\\ für einen\n  Backslash.\n\n-q\n--no-progress\n\n  Unterdrückt die Fortschrittsanzeige.\n\n--json-progress\n\n  Die Fortschrittsanzeige erfolt in Form von JSON-Nachrichten. Jede Nachricht\n  wird durch einen Zeilenumbruch abgeschlossen. Die Ausgabe erfolgt nach STDOUT\n  statt nach STDERR.\n  Werden mehrere Karten kopiert, enthält jede Nachricht zusätzlich die Liste\n  'copies' mit dem Fortschritt jeder Kopie in der Reihenfolge der Argumente.\n\n--direct\n\n  Der StiK bzw. die SD-Karte wird mit Direct I/O am Seitencache des\n  Betriebssystems vorbei gelesen. Dabei sind mehrere Lesezugriffe gleichzeitig\n  unterwegs, damit die Karte ausgelastet bleibt. Unterstützt das Gerät kein\n  Direct I/O, wird es normal gelesen.\n  Ohne diese Option kopiert das Betriebssystem die Daten selbst, wodurch sie auf\n  Dateisystemen wie XFS oder Btrfs mit der Eingabe geteilt werden können.\n\n--queue-depth=N\n\n  Es werden bis zu N Lesezugriffe gleichzeitig gestellt. Kartenleser und\n  USB3-Gehäuse erreichen ihre volle Geschwindigkeit oft erst mit mehreren\n  ausstehenden Lesezugriffen. Der Standardwert ist 4.\n\n--chunk-size=SIZE\n\n  Der StiK bzw. die SD-Karte wird in Blöcken von SIZE Bytes gelesen. Die Größe\n  muss ein Vielfaches von 512 sein und kann mit einem Suffix wie '512k' oder\n  '8M' angegeben werden. Der Standardwert ist 4M.\n\n--checksum\n\n  Während die Kopie geschrieben wird, wird eine CRC32C-Prüfsumme berechnet und\n  im Manifest 'out.6d6.manifest' neben der Kopie gespeichert.\n\n--sha256\n\n  Wie '--checksum', zusätzlich wird ein SHA-256-Hash berechnet.\n\n--verify\n\n  Die als einziges Argument angegebene Kopie wird erneut gelesen und mit ihrem\n  Manifest verglichen. Der Rückgabewert ist 0, wenn die Kopie übereinstimmt.\n\n--resume\n\n  Beim Kopieren werden Checkpoints in 'out.6d6.checkpoint' geschrieben. Wurde\n  die Kopie unterbrochen, prüft derselbe Aufruf den bereits kopierten Teil und\n  setzt die Kopie nach dem letzten gültigen Checkpoint fort.\n\n--drop-cache\n\n  Die Kopie wird aus dem Seitencache des Betriebssystems entfernt, sobald sie\n  auf der Festplatte ist. So bleibt der Cache für andere Programme frei, wenn\n  viele StiKs oder SD-Karten nacheinander kopiert werden.\n\n--bandwidth=RATE\n\n  Es werden höchstens RATE Bytes pro Sekunde kopiert, alle Kopien zusammen\n  gezählt. Die Rate kann mit einem Suffix wie '40M' angegeben werden.\n\nBeispiele\n---------\n\nArchiviert den StiK in '/dev/sdb1' auf eine Backup-Festplatte.\n\n  $ 6d6copy /dev/sdb1 /media/Backup/Experiment-003/Station-007.6d6\n\nKopiert die SD-Karte in '/dev/mmcblk0p1' ins aktuelle Verzeichnis.\n\n  $ 6d6copy /dev/mmcblk0p1 Station-013.6d6\n\nArchiviert einen StiK mit SHA-256-Hash und prüft die Kopie später.\n\n  $ 6d6copy --sha256 /dev/sdb1 Station-007.6d6\n  $ 6d6copy --verify Station-007.6d6\n\nKopiert einen großen StiK so, dass die Kopie nach einer Unterbrechung\nfortgesetzt werden kann.\n\n  $ 6d6copy --resume /dev/sdb1 Station-007.6d6\n\nKopiert drei StiKs gleichzeitig.\n\n  $ 6d6copy /dev/sdb1 Station-007.6d6 /dev/sdc1 Station-008.6d6 /dev/sdd1 Station-009.6d6\n\n",
+  .usage_6d6info_s = "6d6info\n=======\n\nDas Programm '6d6info' zeigt Informationen zu einer 6D6-Aufnahme an.\nEs kann entweder direkt mit einem StiK oder einer SD-Karte verwendet werden oder\nInformationen über eine .6d6-Datei auf der Festplatte anzeigen.\n\nVerwendung\n----------\n\n  %s [Optionen] /dev/sdX1\n\nDer Parameter ist die Datei oder das Gerät, das untersucht werden soll.\n\nOptionen\n--------\n\n--json\n\n  Gibt JSON statt formatiertem Text aus.\n\n--scan\n\n  Liest die ganze Aufnahme durch, statt die Header anzuzeigen. Dabei werden\n  die Kontrollframes gesammelt und die Sampleframes übersprungen, was viel\n  schneller ist als eine Umwandlung. Gibt eine Zusammenfassung in JSON aus\n  mit der Anzahl der Sample- und Zeitframes, den Zeiten des ersten und\n  letzten Zeitframes, der Zeit des letzten Samples, der Anzahl verlorener\n  Frames und Neustarts, ob die Aufnahme einen Endframe hat, und dem Bereich\n  von Temperatur, Luftfeuchtigkeit und Batteriespannung.\n\n--auxfile=FILE\n\n  Erstellt mit --scan zusätzlich eine CSV-Datei mit den Statusdaten unter\n  FILE, genau wie 6d6mseed.\n\nBeispiele\n---------\n\nZeigt Informationen zum StiK in '/dev/sdb1':\n\n  $ 6d6info /dev/sdb1\n\nZeigt Informationen zur Datei 'station-007.6d6' im Ordner 'line-001':\n\n  $ 6d6info line-001/station-007.6d6\n\nErmittelt die tatsächliche Endzeit und den Temperaturverlauf derselben Datei:\n\n  $ 6d6info --scan --auxfile=station-007.csv line-001/station-007.6d6\n\n",
+  .usage_6d6mseed_s = "6d6mseed\n========\n\nDas Programm '6d6mseed' konvertiert Rohdaten des 6D6-Datenloggers in das\nMiniSEED-Format.\n\nVerwendung\n----------\n\n  %s [Optionen] input.6d6\n\nOptionen\n--------\n\n--station=CODE\n\n  Setzt den MiniSEED-Stationscode auf CODE. Der Stationscode ist für die\n  MiniSEED-Erzeugung zwingend erforderlich. Er besteht aus 1 bis 5 alpha-\n  numerischen ASCII-Zeichen.\n\n--location=CODE\n\n  Setzt den Location-Code auf CODE. Der Location-Code besteht aus zwei Zeichen\n  und kann benutzt werden um mehrere Sensoren an einer Station zu unterscheiden.\n\n--network=CODE\n\n  Setzt den Network-Code auf CODE. Dies ist ein zweistelliger Code, der vom\n  IRIS vergeben wird.\n\n--channels=C1,C2,...\n\n  Benutzt abweichende Kanalnamen. Die Namen müssen aus 1 bis 3 alphanumerischen\n  Zeichen bestehen und werden durch Kommata ohne Leerzeichen getrennt.\n  Wenn diese Option benutzt wird, muss für jeden Kanal ein Name festgelegt\n  werden.\n\n--output=FILENAME_TEMPLATE\n\n  Setzt ein Muster für Dateinamen. Im Muster können die folgenden Platzhalter\n  verwendet werden:\n\n    %%y - Jahr\n    %%m - Monat\n    %%d - Tag\n    %%h - Stunde\n    %%i - Minute\n    %%s - Sekunde\n    %%S - Stations-Code\n    %%L - Location-Code\n    %%C - Kanal\n    %%N - Network-Code\n\n  Der Standardwert ist 'out/%%S/%%y-%%m-%%d-%%C.mseed'.\n\n--cut=SECONDS\n\n  Schneidet die Daten in Stücke von SECONDS Sekunden. Der Standardwert ist\n  86400, also ein Tag.\n\n--no-cut\n\n  Schaltet das Schneiden der MiniSEED-Dateien ab und erzeugt stattdessen eine\n  große Datei pro Kanal.\n\n--start-time=TIME\n--end-time=TIME\n\n  Begrenzt die konvertierung auf den angegebenen Zeitraum.\n  Wenn diese Optionen benutzt werden, enthalten die erzeugten MiniSEED-Dateien\n  keine Samples vor der angegebenen Startzeit oder nach der angegebenen Endzeit.\n  Das Lesen endet, sobald alle Kanäle die Endzeit erreicht haben, daher endet\n  auch die Aux-Datei dort.\n\n  Die Standardwerte sind der Anfang und das Ende der Aufzeichnung.\n\n  Die Zeiten müssen als ISO-String angegeben werden, das heißt im Format\n  'YYYY-MM-DDTHH:MM:SSZ'.\n\n--index\n\n  Legt neben der Eingabedatei einen Index der Zeitstempel an, z.B.\n  'ST007.6d6idx' für 'ST007.6d6', falls es noch keinen gibt oder er zu einer\n  anderen Aufzeichnung gehört. Mit einem Index springt '--start-time' direkt\n  zum Anfang, statt alles davor zu dekodieren. Ein vorhandener Index wird auch\n  ohne diese Option verwendet. Ohne Index wird der Anfang durch Bisektion der\n  Aufzeichnung gesucht.\n\n--index-file=FILE\n\n  Verwendet FILE als Index statt der Datei neben der Eingabe. Dies ist nötig,\n  um einen Index für einen StiK oder eine SD-Karte anzulegen.\n\n--logfile=FILE\n\n  Erstellt eine Logdatei unter FILE.\n  Die Logdatei enthält alle wichtigen Ereignisse, die während des Konvertierens\n  auftreten. Das sind hauptsächlich allgemeine Informationen über die Daten,\n  Namen von erstellten Dateien und eventuelle Fehler.\n\n--auxfile=FILE\n\n  Erstellt eine CSV-Datei mit zusätzlichen Daten unter FILE.\n  Die CSV-Datei enthält die Statusdaten des Datenloggers, wie z.B. Temperatur\n  oder Batteriespannung.\n\n--ignore-skew\n\n  Die zweite Synchronisierung wird nicht verwendet. Der Zeitfehler wird\n  hierdurch im Mittel verdoppelt, daher gibt diese Option immer eine Warnung aus\n  und sollte nicht verwendet werden.\n\n--encoding=NAME\n\n  Legt die Kodierung der Samples in den MiniSEED-Records fest. 'int32'\n  speichert jedes Sample in 32 Bit, das ist die Voreinstellung. 'steim1'\n  speichert die Differenzen zwischen den Samples in 8, 16 oder 32 Bit,\n  wodurch die Dateien bei den meisten Aufnahmen zwei- bis dreimal kleiner\n  werden. 'steim2' packt die Differenzen noch dichter in 4 bis 30 Bit.\n  Records, die mit Steim größer würden, wie bei sehr verrauschten Daten,\n  werden als 'int32' gespeichert.\n\n--record-length=BYTES\n\n  Legt die Länge der MiniSEED-Records fest, eine Zweierpotenz von 256 bis\n  65536 Byte. Die Voreinstellung ist 4096. Kurze Records eignen sich, um Daten\n  mit wenig Verzögerung weiterzuleiten, lange Records haben bei großen\n  Archiven weniger Overhead.\n\n--write-buffer=SIZE\n\n  Für jeden Kanal werden SIZE Bytes an Records gesammelt, bevor sie in die\n  Datei geschrieben werden. Die Größe muss ein Vielfaches von 64k sein und kann\n  mit einem Suffix wie '512k' oder '8M' angegeben werden. Der Standardwert ist\n  4M.\n\n--resample\n\n  Die Skew-Korrektur wird durchgeführt, indem die Daten auf die nominelle Samplerate\n  resampled werden.\n\n--direct\n\n  Die Eingabe wird mit Direct I/O am Seitencache des Betriebssystems vorbei\n  gelesen. Dies ist nützlich, wenn große Aufzeichnungen von einem StiK oder einer\n  SD-Karte gelesen werden. Unterstützt das Gerät kein Direct I/O, wird die\n  Eingabe normal gelesen.\n\n--queue-depth=N\n\n  Es werden bis zu N Lesezugriffe auf den StiK bzw. die SD-Karte gleichzeitig\n  gestellt. Kartenleser und USB3-Gehäuse erreichen ihre volle Geschwindigkeit\n  oft erst mit mehreren ausstehenden Lesezugriffen. Der Standardwert ist 4.\n\n--chunk-size=SIZE\n\n  Die Eingabe wird in Blöcken von SIZE Bytes gelesen. Die Größe muss ein\n  Vielfaches von 512 sein und kann mit einem Suffix wie '512k' oder '8M'\n  angegeben werden. Der Standardwert ist 4M.\n\n--threads=N\n\n  Es werden N Threads verwendet. Die Eingabe wird in mehreren Teilen\n  gleichzeitig dekodiert und die Kanäle werden in eigenen Threads\n  umgewandelt, mehr Threads als Kanäle helfen daher kaum. Der Standardwert\n  ist 1.\n\nBeispiele\n---------\n\nKonvertiert die Datei 'ST007.6d6' mit den Standardeinstellungen nach MiniSEED.\nDie Option '--station' wird immer benötigt!\n\n  $ 6d6mseed --station=ST007 ST007.6d6\n\nKonvertiert die Datei 'ST007.6d6' mit einem Network-Code und benutzerdefinierten\nMiniSEED-Dateinamen.\n\n  $ 6d6mseed ST007.6d6 \\\n      --station=ST007 \\\n      --network=XX \\\n      --output=%%N/%%S/%%y-%%m-%%d-%%C.mseed\n\n",
+  .usage_6d6read_s = "6d6read\n=======\n\nDas Programm '6d6read' konvertiert Rohdaten vom 6D6-Datenlogger in das\nSend2X-Format.\nDies kann nützlich sein, wenn noch eine große Anzahl von alten Datenloggern\nvorhanden ist und eine einheitliche Datenverarbeitung gewünscht ist.\n\nVerwendung\n----------\n\n  %s [-q|--no-progress] [--direct] [--queue-depth=N] [--chunk-size=SIZE] < in.6d6 > out.s2x\n\nDie Eingabedatei ist eine .6d6-Datei und wird mit einer öffnenden spitzen\nKlammer angegeben '<'.\nDie Ausgabedatei ist eine .s2x-Datei und wird mit einer schließenden spitzen\nKlammer angegeben '>'.\n\nWenn Eingabedatei eine gültige .6d6-Datei ist, beginnt der Konvertierungs-\nvorgang und der Fortschritt wird im Terminal angezeigt. Um die Ausgabe z.B. für\nautomatisierte Scripts zu unterdrücken, kann die Option '-q' bzw.\n'--no-progress' verwendet werden.\n\nBeim Lesen direkt von einem StiK oder einer SD-Karte wird mit der Option\n'--direct' der Seitencache des Betriebssystems umgangen. Unterstützt das Gerät\nkein Direct I/O, wird es normal gelesen. Mit den Optionen '--queue-depth' und\n'--chunk-size' werden die Anzahl der gleichzeitigen Lesezugriffe (Standard 4)\nund deren Größe (Standard 4M) eingestellt.\n\nDie Optionen '--start-time' und '--end-time' begrenzen die Konvertierung auf\nden angegebenen Zeitraum. Kann die Eingabe springen, sucht '--start-time' den\nAnfang durch Bisektion der Aufzeichnung, statt alles davor zu dekodieren. Wird\ndie Eingabedatei mit Namen angegeben, legt die Option '--index' daneben einen\nIndex der Zeitstempel an, z.B. 'x.6d6idx' für 'x.6d6', falls es noch keinen\ngibt, der stattdessen verwendet wird. Die Option '--index-file=FILE' speichert\nden Index in FILE, was für StiKs, SD-Karten und Eingaben mit '<' nötig ist.\n\nBeispiele\n---------\n\nKonvertiert die Datei 'station-007.6d6' ins Send2X-Format:\n\n  $ 6d6read < station-007.6d6 > station-007.s2x\n\nKonvertiert die Datei 'x.6d6' nach 'y.s2x' ohne Fortschrittsanzeige:\n\n  $ 6d6read --no-progress < x.6d6 > y.s2x\n",
   .using_channel_mapping = "Benutze folgende Kanalzuordnungen:\n",
+  .verify_failed_s = "'%s' stimmt NICHT mit dem Manifest überein!\n",
+  .verify_ok_s = "'%s' stimmt mit dem Manifest überein.\n",
   .version_ss = "6D6 Compatibility Tools Version %s (%s)\n\n",
 };
 const I18n *de_DE = &_de_DE;
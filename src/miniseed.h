@@ -6,15 +6,68 @@
 
 #include <stdint.h>
 
+// The default record length and the range of record lengths. The length
+// must be a power of two.
 #define MINISEED_RECORD_SIZE 4096
+#define MINISEED_MIN_RECORD_SIZE 256
+#define MINISEED_MAX_RECORD_SIZE 65536
+
+// Encoding formats.
+#define MINISEED_INT32 3
+#define MINISEED_STEIM1 10
+#define MINISEED_STEIM2 11
+
+// Number of samples which the Steim encoder takes at once.
+#define MINISEED_STEIM_BATCH 64
 
 typedef struct {
-  uint8_t data[MINISEED_RECORD_SIZE];
+  uint8_t data[MINISEED_MAX_RECORD_SIZE];
+  // The length of the records and the number of samples an int32 record
+  // holds.
+  int size, capacity;
+  // The encoding of the records and the encoding of this record, which is
+  // int32 if Steim did not compress it.
+  int encoding, format;
+  // The number of samples in the record. The header only gets it when the
+  // record is finished.
+  int samples;
+  // Steim: The next data word and the number of free data words, the
+  // differences which are not packed yet with their size class, and the last
+  // sample, to which the first difference of the next record refers.
+  int word, free;
+  int32_t pending[MINISEED_STEIM_BATCH + 8];
+  int32_t size_class[MINISEED_STEIM_BATCH + 8];
+  int pending_first, pending_count;
+  int32_t last;
+  int have_last;
+  // The first samples, to store them as int32 if Steim does not compress.
+  int32_t raw[(MINISEED_MAX_RECORD_SIZE - 64) / 4];
+  // The header which miniseed_record_init_template copies.
+  uint8_t header[64];
+  int have_header;
 } MiniSeedRecord;
 
+// Set the encoding format of the following records. This has to be called
+// once before the first record is initialized.
+int miniseed_record_set_encoding(MiniSeedRecord *r, int encoding);
+
+// Set the length of the following records in bytes, a power of two from
+// MINISEED_MIN_RECORD_SIZE to MINISEED_MAX_RECORD_SIZE, usually
+// MINISEED_RECORD_SIZE. This has to be called once before the first record is
+// initialized.
+int miniseed_record_set_length(MiniSeedRecord *r, int size);
+
 // Initialize a MiniSeed record with a record number.
 int miniseed_record_init(MiniSeedRecord *r, int record_number);
 
+// Keep the header of the record, which has to be initialized with info fields
+// and sample rate, as the template for the following records.
+int miniseed_record_set_template(MiniSeedRecord *r);
+
+// Initialize a MiniSeed record like miniseed_record_init from the template
+// header with a record number. Returns -1 if there is no template.
+int miniseed_record_init_template(MiniSeedRecord *r, int record_number);
+
 // Set the info fields on a MiniSeed record
 int miniseed_record_set_info(MiniSeedRecord *r, const char *station, const char *location, const char *channel, const char *network);
 
@@ -28,9 +81,16 @@ int miniseed_record_set_sample_rate(MiniSeedRecord *r, double sample_rate);
 // Push a sample to the record. Returns -1 if the record is full.
 int miniseed_record_push_sample(MiniSeedRecord *r, int32_t sample);
 
+// Push up to `n` samples to the record. Returns the number of samples pushed,
+// which is less than `n` if the record is full.
+int miniseed_record_push_samples(MiniSeedRecord *r, const int32_t *samples, int n);
+
 // Mark a record as containing a leap second.
 int miniseed_record_set_leapsec(MiniSeedRecord *r, int leapsec);
 
+// Complete the data of the record before writing it.
+int miniseed_record_finish(MiniSeedRecord *r);
+
 #endif
 
 #ifdef MINISEED_IMPLEMENTATION
@@ -38,15 +98,54 @@ int miniseed_record_set_leapsec(MiniSeedRecord *r, int leapsec);
 
 #include <string.h>
 
-int miniseed_record_init(MiniSeedRecord *r, int record_number)
+// Offset of the data and the number of data words in Steim frames of
+// 16 words each.
+#define MINISEED__DATA 64
+#define MINISEED__FRAMES(r) (((r)->size - MINISEED__DATA) / 64)
+
+int miniseed_record_set_encoding(MiniSeedRecord *r, int encoding)
+{
+  if (!r || (encoding != MINISEED_INT32 && encoding != MINISEED_STEIM1 && encoding != MINISEED_STEIM2)) return -1;
+  r->encoding = encoding;
+  r->have_last = 0;
+  r->have_header = 0;
+  return 0;
+}
+
+int miniseed_record_set_length(MiniSeedRecord *r, int size)
+{
+  if (!r || size < MINISEED_MIN_RECORD_SIZE || size > MINISEED_MAX_RECORD_SIZE || (size & (size - 1))) return -1;
+  r->size = size;
+  r->have_header = 0;
+  // Records of the default length hold 1000 samples, as they always did.
+  // Other lengths use all of the record.
+  r->capacity = size == MINISEED_RECORD_SIZE ? 1000 : (size - MINISEED__DATA) / 4;
+  return 0;
+}
+
+static void miniseed__start(MiniSeedRecord *r, int record_number)
 {
   int i;
-  if (!r) return -1;
-  memset(r->data, 0, MINISEED_RECORD_SIZE);
+  // The first frame starts with the control word and the forward and reverse
+  // integration constants.
+  r->format = r->encoding;
+  r->samples = 0;
+  r->word = 3;
+  r->free = MINISEED__FRAMES(r) * 15 - 2;
+  r->pending_first = 0;
+  r->pending_count = 0;
   for (i = 0; i < 6; ++i) {
     r->data[5 - i] = '0' + (record_number % 10);
     record_number /= 10;
   }
+}
+
+int miniseed_record_init(MiniSeedRecord *r, int record_number)
+{
+  int i;
+  if (!r) return -1;
+  memset(r->data, 0, r->size);
+  miniseed__start(r, record_number);
   r->data[6] = 'D';
   memset(r->data + 7, ' ', 13);
   // Number of blockettes.
@@ -59,11 +158,31 @@ int miniseed_record_init(MiniSeedRecord *r, int record_number)
   r->data[48] = 0x03;
   r->data[49] = 0xe8;
   // Encoding format.
-  r->data[52] = 3;
+  r->data[52] = r->encoding;
   // Word order.
   r->data[53] = 1;
-  // Data record length.
-  r->data[54] = 12;
+  // Data record length as a power of two.
+  for (i = 0; (1 << i) < r->size; ++i);
+  r->data[54] = i;
+  return 0;
+}
+
+int miniseed_record_set_template(MiniSeedRecord *r)
+{
+  if (!r) return -1;
+  memcpy(r->header, r->data, sizeof(r->header));
+  r->have_header = 1;
+  return 0;
+}
+
+int miniseed_record_init_template(MiniSeedRecord *r, int record_number)
+{
+  if (!r || !r->have_header) return -1;
+  memcpy(r->data, r->header, sizeof(r->header));
+  // Int32 records overwrite their data and only clear the rest when they are
+  // finished. The control words of Steim frames have to start out as zero.
+  if (r->encoding != MINISEED_INT32) memset(r->data + MINISEED__DATA, 0, r->size - MINISEED__DATA);
+  miniseed__start(r, record_number);
   return 0;
 }
 
@@ -140,21 +259,254 @@ int miniseed_record_set_sample_rate(MiniSeedRecord *r, double sample_rate)
 
 int miniseed_record_push_sample(MiniSeedRecord *r, int32_t sample)
 {
-  int num_samples, i;
+  uint8_t *p;
   if (!r) return -1;
-  num_samples = r->data[30] * 256 + r->data[31];
-  if (num_samples >= 1000) return -1;
-  i = 64 + num_samples * 4;
-  r->data[i] = sample >> 24;
-  r->data[i + 1] = sample >> 16;
-  r->data[i + 2] = sample >> 8;
-  r->data[i + 3] = sample;
-  num_samples += 1;
-  r->data[30] = num_samples >> 8;
-  r->data[31] = num_samples;
+  if (r->encoding != MINISEED_INT32) return miniseed_record_push_samples(r, &sample, 1) == 1 ? 0 : -1;
+  if (r->samples >= r->capacity) return -1;
+  p = r->data + MINISEED__DATA + 4 * r->samples;
+  p[0] = sample >> 24;
+  p[1] = sample >> 16;
+  p[2] = sample >> 8;
+  p[3] = sample;
+  r->samples += 1;
+  return 0;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define MINISEED__SSE2
+#endif
+
+// Store `n` samples as big endian words, four at a time with SSE2 where
+// available.
+static void miniseed__store_be(uint8_t *p, const int32_t *samples, int n)
+{
+  uint32_t x;
+  int k = 0;
+#ifdef MINISEED__SSE2
+  __m128i a;
+  for (; k + 4 <= n; k += 4) {
+    a = _mm_loadu_si128((const __m128i *) (samples + k));
+    // Swap the bytes of every half word, then the half words.
+    a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+    a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0xb1), 0xb1);
+    _mm_storeu_si128((__m128i *) (p + 4 * k), a);
+  }
+#endif
+  for (; k < n; ++k) {
+    x = samples[k];
+    p[4 * k] = x >> 24;
+    p[4 * k + 1] = x >> 16;
+    p[4 * k + 2] = x >> 8;
+    p[4 * k + 3] = x;
+  }
+}
+
+static int miniseed__int32_push_samples(MiniSeedRecord *r, const int32_t *samples, int n)
+{
+  if (n > r->capacity - r->samples) n = r->capacity - r->samples;
+  miniseed__store_be(r->data + MINISEED__DATA + 4 * r->samples, samples, n);
+  r->samples += n;
+  return n;
+}
+
+static void miniseed__put_word(MiniSeedRecord *r, int word, uint32_t x)
+{
+  uint8_t *p = r->data + MINISEED__DATA + 4 * word;
+  p[0] = x >> 24;
+  p[1] = x >> 16;
+  p[2] = x >> 8;
+  p[3] = x;
+}
+
+// Append a data word with `n` differences of `bits` bits each to the Steim
+// frames and put its code into the control word at the start of the frame.
+static void miniseed__steim_emit(MiniSeedRecord *r, int n, int bits, uint32_t x, int code)
+{
+  const int32_t *d = r->pending + r->pending_first;
+  uint32_t mask = bits == 32 ? 0xffffffff : ((uint32_t) 1 << bits) - 1;
+  int w = r->word, shift = 2 * (15 - w % 16), i;
+  for (i = 0; i < n; ++i) {
+    x |= ((uint32_t) d[i] & mask) << (bits * (n - 1 - i));
+  }
+  miniseed__put_word(r, w, x);
+  r->data[MINISEED__DATA + 4 * (w - w % 16) + 3 - shift / 8] |= code << (shift % 8);
+  r->free -= 1;
+  r->pending_first += n;
+  r->pending_count -= n;
+  w += 1;
+  if (w % 16 == 0) w += 1;
+  r->word = w;
+}
+
+// The size classes of the differences: A difference of class c fits into
+// miniseed__class_bits[c] bits.
+static const int miniseed__class_bits[9] = {4, 5, 6, 8, 10, 15, 16, 30, 32};
+
+// Pack the next differences into one word, the most that fit. Unless
+// `finish` is set, there have to be enough differences to choose from.
+// Returns -1 if there are not.
+static int miniseed__steim1_pack(MiniSeedRecord *r, int finish)
+{
+  const int32_t *c = r->size_class + r->pending_first;
+  int n = r->pending_count;
+  if (n < 4 && !finish) return -1;
+  if (n >= 4 && c[0] <= 3 && c[1] <= 3 && c[2] <= 3 && c[3] <= 3) {
+    miniseed__steim_emit(r, 4, 8, 0, 1);
+  } else if (n >= 2 && c[0] <= 6 && c[1] <= 6) {
+    miniseed__steim_emit(r, 2, 16, 0, 2);
+  } else {
+    miniseed__steim_emit(r, 1, 32, 0, 3);
+  }
   return 0;
 }
 
+static int miniseed__steim2_pack(MiniSeedRecord *r, int finish)
+{
+  // The largest class for 1 to 7 differences per word, with their code and
+  // the two bits in front of the differences.
+  static const int limit[8] = {0, 7, 5, 4, 3, 2, 1, 0};
+  static const int code[8] = {0, 2, 2, 2, 1, 3, 3, 3};
+  static const uint32_t head[8] = {0, 1, 2, 3, 0, 0, 1, 2};
+  const int32_t *c = r->size_class + r->pending_first;
+  int n, m = 0;
+  if (r->pending_count < 7 && !finish) return -1;
+  for (n = 0; n < 7 && n < r->pending_count; ++n) {
+    if (c[n] > m) m = c[n];
+    if (m > limit[n + 1]) break;
+  }
+  miniseed__steim_emit(r, n, miniseed__class_bits[limit[n]], head[n] << 30, code[n]);
+  return 0;
+}
+
+// Compute the differences of `n` samples to their predecessors and their size
+// classes, four at a time with SSE2 where available. `samples[-1]` must be
+// the sample before the first one.
+static void miniseed__steim_classify(const int32_t *samples, int n, int32_t *d, int32_t *c)
+{
+  static const int32_t limits[8] = {7, 15, 31, 127, 511, 16383, 32767, 536870911};
+  int32_t t;
+  int i = 0, j;
+#ifdef MINISEED__SSE2
+  __m128i x, y, k;
+  for (; i + 4 <= n; i += 4) {
+    x = _mm_sub_epi32(_mm_loadu_si128((const __m128i *) (samples + i)), _mm_loadu_si128((const __m128i *) (samples + i - 1)));
+    _mm_storeu_si128((__m128i *) (d + i), x);
+    // Negative differences fit as well as their complements.
+    x = _mm_xor_si128(x, _mm_srai_epi32(x, 31));
+    y = _mm_setzero_si128();
+    for (j = 0; j < 8; ++j) {
+      k = _mm_cmpgt_epi32(x, _mm_set1_epi32(limits[j]));
+      y = _mm_sub_epi32(y, k);
+    }
+    _mm_storeu_si128((__m128i *) (c + i), y);
+  }
+#endif
+  for (; i < n; ++i) {
+    d[i] = (int32_t) ((uint32_t) samples[i] - (uint32_t) samples[i - 1]);
+    t = d[i] ^ (d[i] >> 31);
+    c[i] = 0;
+    for (j = 0; j < 8; ++j) {
+      c[i] += t > limits[j];
+    }
+  }
+}
+
+// Store the samples of the record as int32 instead.
+static void miniseed__int32_fallback(MiniSeedRecord *r)
+{
+  int n;
+  memset(r->data + MINISEED__DATA, 0, r->size - MINISEED__DATA);
+  r->format = MINISEED_INT32;
+  r->data[52] = MINISEED_INT32;
+  n = r->samples;
+  r->samples = 0;
+  miniseed__int32_push_samples(r, r->raw, n);
+  r->pending_count = 0;
+}
+
+static int miniseed__steim_push_samples(MiniSeedRecord *r, const int32_t *samples, int n)
+{
+  int32_t batch[MINISEED_STEIM_BATCH + 1];
+  int32_t *d, *c;
+  int done = 0, k, j, stop;
+  int (*pack)(MiniSeedRecord *, int) = r->format == MINISEED_STEIM1 ? miniseed__steim1_pack : miniseed__steim2_pack;
+
+  while (done < n) {
+    if (r->format == MINISEED_INT32) {
+      k = miniseed__int32_push_samples(r, samples + done, n - done);
+      if (k) r->last = samples[done + k - 1];
+      return done + k;
+    }
+    // Every difference takes one word at worst.
+    k = n - done;
+    if (k > r->free - r->pending_count) k = r->free - r->pending_count;
+    if (k > MINISEED_STEIM_BATCH) k = MINISEED_STEIM_BATCH;
+    // The number of samples has to fit into the header.
+    if (k > 65535 - r->samples) k = 65535 - r->samples;
+    if (k <= 0) {
+      // The record is full. Int32 would have held more samples.
+      if (r->samples < r->capacity) {
+        miniseed__int32_fallback(r);
+        continue;
+      }
+      break;
+    }
+    if (r->pending_first) {
+      memmove(r->pending, r->pending + r->pending_first, sizeof(*r->pending) * r->pending_count);
+      memmove(r->size_class, r->size_class + r->pending_first, sizeof(*r->size_class) * r->pending_count);
+      r->pending_first = 0;
+    }
+    d = r->pending + r->pending_count;
+    c = r->size_class + r->pending_count;
+    batch[0] = r->have_last ? r->last : samples[done];
+    memcpy(batch + 1, samples + done, sizeof(*batch) * k);
+    miniseed__steim_classify(batch + 1, k, d, c);
+    // The first difference of a record does not count for the samples, so it
+    // may be left out if it does not fit.
+    if (!r->samples && c[0] > 7) {
+      d[0] = 0;
+      c[0] = 0;
+    }
+    // Steim-2 can not store differences of more than 30 bits.
+    stop = 0;
+    if (r->format == MINISEED_STEIM2) {
+      for (j = 0; j < k && c[j] <= 7; ++j);
+      if (j < k) {
+        k = j;
+        stop = 1;
+      }
+    }
+    if (k) {
+      if (!r->samples) miniseed__put_word(r, 1, samples[done]);
+      if (r->samples < r->capacity) {
+        memcpy(r->raw + r->samples, samples + done, sizeof(*r->raw) * (r->samples + k < r->capacity ? k : r->capacity - r->samples));
+      }
+      r->pending_count += k;
+      r->samples += k;
+      r->last = samples[done + k - 1];
+      r->have_last = 1;
+      done += k;
+      while (pack(r, 0) == 0);
+    }
+    if (stop) {
+      if (r->samples < r->capacity) {
+        miniseed__int32_fallback(r);
+        continue;
+      }
+      break;
+    }
+  }
+  return done;
+}
+
+int miniseed_record_push_samples(MiniSeedRecord *r, const int32_t *samples, int n)
+{
+  if (!r || n < 0) return -1;
+  if (r->encoding != MINISEED_INT32) return miniseed__steim_push_samples(r, samples, n);
+  return miniseed__int32_push_samples(r, samples, n);
+}
+
 int miniseed_record_set_leapsec(MiniSeedRecord *r, int leapsec)
 {
   if (!r) return -1;
@@ -165,4 +517,24 @@ int miniseed_record_set_leapsec(MiniSeedRecord *r, int leapsec)
   return 0;
 }
 
+int miniseed_record_finish(MiniSeedRecord *r)
+{
+  if (!r) return -1;
+  if (r->format == MINISEED_INT32) {
+    memset(r->data + MINISEED__DATA + 4 * r->samples, 0, r->size - MINISEED__DATA - 4 * r->samples);
+  } else {
+    while (r->pending_count) {
+      if (r->format == MINISEED_STEIM1) {
+        miniseed__steim1_pack(r, 1);
+      } else {
+        miniseed__steim2_pack(r, 1);
+      }
+    }
+    if (r->samples) miniseed__put_word(r, 2, r->last);
+  }
+  r->data[30] = r->samples >> 8;
+  r->data[31] = r->samples;
+  return 0;
+}
+
 #endif
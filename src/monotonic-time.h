@@ -33,3 +33,10 @@ static inline int64_t monotonic_time_ms(int ms)
 }
 
 #endif
+
+// Bytes per second for `bytes` transferred in the monotonic interval `t`.
+static inline int64_t monotonic_throughput(int64_t bytes, int64_t t)
+{
+  if (t <= 0) return 0;
+  return bytes * (double) monotonic_time_ms(1000) / t;
+}
@@ -19,10 +19,17 @@ Samplebuffer *samplebuffer_new(void);
 // Push a sample to the sample buffer. The buffer grows if necessary.
 void samplebuffer_push(Samplebuffer *sb, int32_t sample);
 
+// Push `n` samples to the sample buffer. The buffer grows if necessary.
+void samplebuffer_push_n(Samplebuffer *sb, const int32_t *samples, int n);
+
 // Return the next sample from the sample buffer.
 // Returns 0 if the sample buffer is empty.
 int32_t samplebuffer_pop(Samplebuffer *sb);
 
+// Move up to `n` samples from the sample buffer to `out`. The samples are
+// dropped if `out` is 0. Returns the number of samples.
+int samplebuffer_pop_n(Samplebuffer *sb, int32_t *out, int n);
+
 // Deletes a sample buffer.
 void samplebuffer_destroy(Samplebuffer *sb);
 
@@ -33,6 +40,7 @@ void samplebuffer_destroy(Samplebuffer *sb);
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 Samplebuffer *samplebuffer_new()
 {
@@ -52,32 +60,52 @@ fail:
   return 0;
 }
 
-void samplebuffer_push(Samplebuffer *sb, int32_t sample)
+// Grow the buffer to hold at least `need` samples.
+static void samplebuffer__grow(Samplebuffer *sb, int need)
 {
-  int i;
+  int i, size = sb->size;
   int32_t *buf;
+  while (size < need) {
+    size *= 2;
+  }
+  buf = (int32_t *) malloc(sizeof(*buf) * size);
+  if (!buf) {
+    fprintf(stderr, "Out of memory!\n");
+    exit(1);
+    return;
+  }
+  for (i = 0; i < sb->len; ++i) {
+    buf[i] = sb->data[(sb->pos + i) % sb->size];
+  }
+  free(sb->data);
+  sb->data = buf;
+  sb->pos = 0;
+  sb->size = size;
+}
+
+void samplebuffer_push(Samplebuffer *sb, int32_t sample)
+{
   if (!sb) return;
   // Grow buffer if necessary.
-  if (sb->len == sb->size) {
-    buf = (int32_t *) malloc(sizeof(*buf) * sb->size * 2);
-    if (!buf) {
-      fprintf(stderr, "Out of memory!\n");
-      exit(1);
-      return;
-    }
-    for (i = 0; i < sb->len; ++i) {
-      buf[i] = sb->data[(sb->pos + i) % sb->size];
-    }
-    free(sb->data);
-    sb->data = buf;
-    sb->pos = 0;
-    sb->size *= 2;
-  }
+  if (sb->len == sb->size) samplebuffer__grow(sb, sb->len + 1);
   // Push the sample.
   sb->data[(sb->pos + sb->len) % sb->size] = sample;
   sb->len += 1;
 }
 
+void samplebuffer_push_n(Samplebuffer *sb, const int32_t *samples, int n)
+{
+  int end, k;
+  if (!sb || n <= 0) return;
+  if (sb->len + n > sb->size) samplebuffer__grow(sb, sb->len + n);
+  // The free space may wrap around the end of the buffer.
+  end = (sb->pos + sb->len) % sb->size;
+  k = n < sb->size - end ? n : sb->size - end;
+  memcpy(sb->data + end, samples, sizeof(*samples) * k);
+  memcpy(sb->data, samples + k, sizeof(*samples) * (n - k));
+  sb->len += n;
+}
+
 int32_t samplebuffer_pop(Samplebuffer *sb)
 {
   int32_t sample;
@@ -89,6 +117,23 @@ int32_t samplebuffer_pop(Samplebuffer *sb)
   return sample;
 }
 
+int samplebuffer_pop_n(Samplebuffer *sb, int32_t *out, int n)
+{
+  int k;
+  if (!sb || n <= 0) return 0;
+  if (n > sb->len) n = sb->len;
+  if (out) {
+    // The samples may wrap around the end of the buffer.
+    k = n < sb->size - sb->pos ? n : sb->size - sb->pos;
+    memcpy(out, sb->data + sb->pos, sizeof(*out) * k);
+    memcpy(out + k, sb->data, sizeof(*out) * (n - k));
+  }
+  sb->pos = (sb->pos + n) % sb->size;
+  sb->len -= n;
+  sb->sample_number += n;
+  return n;
+}
+
 void samplebuffer_destroy(Samplebuffer *sb)
 {
   if (sb) {
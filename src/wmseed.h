@@ -1,6 +1,7 @@
 #ifndef WMSEED_INCLUDE
 #define WMSEED_INCLUDE
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include "miniseed.h"
@@ -8,6 +9,9 @@
 #include "samplebuffer.h"
 #include "resampler.h"
 
+// The default size of the output buffer of each writer.
+#define WMSEED_BUFFER_SIZE (4 << 20)
+
 typedef struct {
   int64_t cut;
   int64_t cut_section;
@@ -20,12 +24,16 @@ typedef struct {
   Time record_time;
   MiniSeedRecord record[1];
   int data_pending;
-  FILE *output;
+  // The output file and the records which are not written yet.
+  int output;
+  uint8_t *buffer;
+  size_t buffer_size, buffered;
   FILE *logfile;
   Time last_t;
   Time start_time;
   Time end_time;
   int first_file_created;
+  int finished;
   int64_t last_sn;
   struct Resampler *resampler;
 } WMSeed;
@@ -36,12 +44,26 @@ WMSeed *wmseed_new(FILE *logfile, const char *file_name_template, const char *st
 int wmseed_destroy(WMSeed *w);
 // Push a sample to the MiniSEED writer.
 int wmseed_sample(WMSeed *w, int32_t sample);
+// Push `n` samples to the MiniSEED writer.
+int wmseed_samples(WMSeed *w, const int32_t *samples, size_t n);
 // Set the time of the next sample.
 int wmseed_time(WMSeed *w, Time t);
 // Limit the start time.
 int wmseed_start_time(WMSeed *w, Time t);
 // Limit the end time.
 int wmseed_end_time(WMSeed *w, Time t);
+// Set the encoding of the records, MINISEED_INT32, MINISEED_STEIM1 or
+// MINISEED_STEIM2. Must be called before the first sample.
+int wmseed_encoding(WMSeed *w, int encoding);
+// Set the length of the records in bytes, a power of two from 256 to 65536.
+// Must be called before the first sample.
+int wmseed_record_length(WMSeed *w, int size);
+// Set the size of the output buffer in bytes, a multiple of 64k. The records
+// are written once the buffer is full. Must be called before the first
+// sample.
+int wmseed_buffer_size(WMSeed *w, size_t size);
+// Check if all samples before the end time have been written.
+int wmseed_finished(WMSeed *w);
 
 #endif
 
@@ -55,6 +77,7 @@ int wmseed_end_time(WMSeed *w, Time t);
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <math.h>
 #include "i18n.h"
 
@@ -252,6 +275,30 @@ int wmseed_end_time(WMSeed *w, Time t)
   return 0;
 }
 
+int wmseed_encoding(WMSeed *w, int encoding)
+{
+  if (!w) return -1;
+  return miniseed_record_set_encoding(w->record, encoding);
+}
+
+int wmseed_record_length(WMSeed *w, int size)
+{
+  if (!w) return -1;
+  return miniseed_record_set_length(w->record, size);
+}
+
+int wmseed_buffer_size(WMSeed *w, size_t size)
+{
+  if (!w || w->buffer || !size || size % MINISEED_MAX_RECORD_SIZE) return -1;
+  w->buffer_size = size;
+  return 0;
+}
+
+int wmseed_finished(WMSeed *w)
+{
+  return w && w->finished;
+}
+
 static int wmseed__sample(WMSeed *w, int32_t sample)
 {
   if (!w || w->last_sn < 0) return -1;
@@ -260,17 +307,61 @@ static int wmseed__sample(WMSeed *w, int32_t sample)
   return 0;
 }
 
+static int wmseed__samples(WMSeed *w, const int32_t *samples, size_t n)
+{
+  size_t k;
+  if (!w || w->last_sn < 0) return -1;
+  // Keep the chunks within the range of the sample buffer.
+  while (n) {
+    k = n < 65536 ? n : 65536;
+    samplebuffer_push_n(w->sb, samples, k);
+    w->sample_number += k;
+    samples += k;
+    n -= k;
+  }
+  return 0;
+}
+
+// Write the buffered records to the output file.
+static void wmseed__write(WMSeed *w)
+{
+  size_t done = 0;
+  ssize_t n;
+  while (done < w->buffered) {
+    n = write(w->output, w->buffer + done, w->buffered - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      wmseed__log(w, stderr, i18n->io_error_d, 21);
+      exit(1);
+    }
+    done += n;
+  }
+  w->buffered = 0;
+}
+
+static void wmseed__close(WMSeed *w)
+{
+  if (w->output < 0) return;
+  wmseed__write(w);
+  if (close(w->output)) {
+    wmseed__log(w, stderr, i18n->io_error_d, 22);
+    exit(1);
+  }
+  w->output = -1;
+}
+
 static void wmseed__flush(WMSeed *w)
 {
   if (w->data_pending) {
-    if (!w->output) {
+    if (w->output < 0) {
       wmseed__log(w, stderr, i18n->io_error_d, 20);
       exit(1);
     }
-    if (fwrite(w->record->data, sizeof(w->record->data), 1, w->output) != 1) {
-      wmseed__log(w, stderr, i18n->io_error_d, 21);
-      exit(1);
-    }
+    miniseed_record_finish(w->record);
+    // The buffer holds a whole number of records of any length.
+    memcpy(w->buffer + w->buffered, w->record->data, w->record->size);
+    w->buffered += w->record->size;
+    if (w->buffered == w->buffer_size) wmseed__write(w);
     w->data_pending = 0;
   }
 }
@@ -285,8 +376,9 @@ int wmseed_destroy(WMSeed *w)
   // TODO: Flush the data from the sample buffer.
   wmseed__flush(w);
   // Close files.
-  if (w->output) fclose(w->output);
+  wmseed__close(w);
   // Free everything.
+  free(w->buffer);
   free(w->file_name_template);
   free(w->station);
   free(w->location);
@@ -309,9 +401,13 @@ static void wmseed__new_record(WMSeed *w, Time t)
   w->record_number += 1;
   w->record_time = t;
   w->data_pending = 0;
-  miniseed_record_init(w->record, w->record_number);
-  miniseed_record_set_info(w->record, w->station, w->location, w->channel, w->network);
-  miniseed_record_set_sample_rate(w->record, w->sample_rate);
+  // The header only differs in the record number and the time.
+  if (miniseed_record_init_template(w->record, w->record_number)) {
+    miniseed_record_init(w->record, w->record_number);
+    miniseed_record_set_info(w->record, w->station, w->location, w->channel, w->network);
+    miniseed_record_set_sample_rate(w->record, w->sample_rate);
+    miniseed_record_set_template(w->record);
+  }
   d = tai_date(t, 0, 0);
   miniseed_record_set_start_time(w->record, d.year, d.month, d.day, d.hour, d.min, d.sec, d.usec / 100, 0);
 }
@@ -321,15 +417,17 @@ static void wmseed__create_file(WMSeed *w, Time t)
   char *filename, *dirname;
   w->record_number = 0;
   wmseed__new_record(w, t);
-  if (w->output) {
-    fclose(w->output);
+  wmseed__close(w);
+  if (!w->buffer && posix_memalign((void **) &w->buffer, 4096, w->buffer_size)) {
+    wmseed__log(w, stderr, "%s", i18n->out_of_memory);
+    exit(1);
   }
   filename = wmseed__filename(w, t);
   dirname = wmseed__dirname(w, filename);
   wmseed__mkdir_p(w, dirname);
   free(dirname);
-  w->output = fopen(filename, "wb");
-  if (!w->output) {
+  w->output = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (w->output < 0) {
     wmseed__log(w, stderr, i18n->could_not_create_file_ss, filename, strerror(errno));
     exit(1);
   } else {
@@ -341,6 +439,54 @@ static void wmseed__create_file(WMSeed *w, Time t)
 // b must be positive.
 #define wmseed__div(a, b) ((a) / (b) - ((a) % (b) < 0))
 
+// Time of sample `n` between the last two timestamps.
+static Time wmseed__sample_time(WMSeed *w, double a, int64_t n)
+{
+  return w->last_t + (int64_t) floor((n - w->last_sn) * a);
+}
+
+static int64_t wmseed__cut_section(WMSeed *w, Time t)
+{
+  return w->cut ? wmseed__div(t - 1000000 * tai_utc_diff(t), w->cut) : 0;
+}
+
+// Pop the next samples when all of them go to the current record or are
+// dropped without changing anything else. Returns the number of samples or 0
+// if the next sample has to be handled on its own.
+static int wmseed__time_batch(WMSeed *w, double a)
+{
+  int32_t samples[1000];
+  int n, k, j;
+  int64_t s = w->sb->sample_number;
+  Time first, last;
+  n = w->sb->len < 1000 ? w->sb->len : 1000;
+  first = wmseed__sample_time(w, a, s);
+  last = wmseed__sample_time(w, a, s + n - 1);
+  if (first >= w->end_time) {
+    w->finished = 1;
+    return samplebuffer_pop_n(w->sb, 0, n);
+  }
+  if (last >= w->end_time) return 0;
+  if (!w->first_file_created) {
+    if (last >= w->start_time) return 0;
+    return samplebuffer_pop_n(w->sb, 0, n);
+  }
+  // The difference to UTC only grows, so the cut section is the same for all
+  // samples if it is the same for the first and the last one.
+  if (tai_utc_diff(first) != tai_utc_diff(last)) return 0;
+  if (wmseed__cut_section(w, first) != w->cut_section || wmseed__cut_section(w, last) != w->cut_section) return 0;
+  samplebuffer_pop_n(w->sb, samples, n);
+  for (j = 0; j < n; j += k) {
+    k = miniseed_record_push_samples(w->record, samples + j, n - j);
+    // Short records may fill up several times.
+    if (k) w->data_pending = 1;
+    if (k < n - j) {
+      wmseed__new_record(w, wmseed__sample_time(w, a, s + j + k));
+    }
+  }
+  return n;
+}
+
 static int wmseed__time(WMSeed *w, Time t)
 {
   int32_t sample;
@@ -366,12 +512,12 @@ static int wmseed__time(WMSeed *w, Time t)
   a = (double) (t - w->last_t) / (w->sample_number - w->last_sn);
 
   while (w->sb->len && w->sb->sample_number <= w->sample_number) {
+    // Most samples are simply copied to the record.
+    if (wmseed__time_batch(w, a)) continue;
+    tt = wmseed__sample_time(w, a, w->sb->sample_number);
     sample = samplebuffer_pop(w->sb);
-    tt = w->last_t + (int64_t) floor((w->sb->sample_number - w->last_sn - 1) * a);
     // Calculate cut section.
-    if (w->cut) {
-      cut_section = wmseed__div(tt - 1000000 * tai_utc_diff(tt), w->cut);
-    }
+    cut_section = wmseed__cut_section(w, tt);
     // Ignore samples after the end time.
     if (tt < w->end_time) {
       // Create a new file if the start time has been reached or the cut section has changed.
@@ -388,6 +534,9 @@ static int wmseed__time(WMSeed *w, Time t)
         }
         w->data_pending = 1;
       }
+    } else {
+      // Samples come in order, so everything before the end time is done.
+      w->finished = 1;
     }
   }
 
@@ -401,10 +550,14 @@ static int wmseed__time(WMSeed *w, Time t)
 static void wmseed__resampler_callback(void *userdata, float *samples, int number_of_samples, int64_t start_time)
 {
   WMSeed *w = (WMSeed *) userdata;
+  int32_t chunk[1024];
+  int i, k;
   wmseed__time(w, start_time);
-  int i;
-  for (i = 0; i < number_of_samples; ++i) {
-    wmseed__sample(w, samples[i]);
+  for (i = 0; i < number_of_samples; i += k) {
+    for (k = 0; k < 1024 && i + k < number_of_samples; ++k) {
+      chunk[k] = samples[i + k];
+    }
+    wmseed__samples(w, chunk, k);
   }
 }
 
@@ -418,6 +571,19 @@ int wmseed_sample(WMSeed *w, int32_t sample)
   }
 }
 
+int wmseed_samples(WMSeed *w, const int32_t *samples, size_t n)
+{
+  size_t i;
+  if (w->resampler) {
+    for (i = 0; i < n; ++i) {
+      resampler_sample(w->resampler, samples[i]);
+    }
+    return 0;
+  } else {
+    return wmseed__samples(w, samples, n);
+  }
+}
+
 int wmseed_time(WMSeed *w, Time t)
 {
   if (w->resampler) {
@@ -445,12 +611,18 @@ WMSeed *wmseed_new(FILE *logfile, const char *file_name_template, const char *st
   w->record_number = 0;
   w->record_time = 0;
   w->data_pending = 0;
-  w->output = 0;
+  w->output = -1;
+  w->buffer = 0;
+  w->buffer_size = WMSEED_BUFFER_SIZE;
+  w->buffered = 0;
   w->last_t = 0;
   w->last_sn = -1;
   w->start_time = INT64_MIN;
   w->end_time = INT64_MAX;
   w->first_file_created = 0;
+  w->finished = 0;
+  miniseed_record_set_encoding(w->record, MINISEED_INT32);
+  miniseed_record_set_length(w->record, MINISEED_RECORD_SIZE);
   if (resampling) {
     w->resampler = resampler_new(sample_rate, wmseed__resampler_callback, w);
     if (!w->resampler) {
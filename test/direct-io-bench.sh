@@ -0,0 +1,22 @@
+#!/bin/sh
+# Compare buffered and direct reads from a block device.
+# Needs root for the loop device and for dropping the page cache.
+# Usage: sudo ./direct-io-bench.sh recording.6d6
+set -e
+dev=$(losetup --find --show --read-only "$1")
+out=$(mktemp -d)
+trap 'losetup -d $dev; rm -rf $out' EXIT
+for tool in 6d6copy 6d6mseed 6d6read; do
+  for mode in "" --direct; do
+    sync
+    echo 3 > /proc/sys/vm/drop_caches
+    start=$(date +%s.%N)
+    case $tool in
+      6d6copy) ../build/6d6copy -q $mode $dev $out/copy.6d6;;
+      6d6mseed) ../build/6d6mseed -q $mode --station=BENCH --output="$out/%C.mseed" $dev > /dev/null 2>&1;;
+      6d6read) ../build/6d6read -q $mode < $dev > $out/out.s2x;;
+    esac
+    end=$(date +%s.%N)
+    echo "$tool ${mode:-buffered} $start $end" | awk '{printf "%-8s %-8s %6.2f s\n", $1, $2, $4 - $3}'
+  done
+done